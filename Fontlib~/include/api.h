@@ -15,7 +15,16 @@
 
 #define TEXTLIB_DEBUG
 
+#ifdef _WIN32
 #define EXPORT_DLL extern "C" __declspec(dllexport)
+#else
+#define EXPORT_DLL extern "C" __attribute__((visibility("default")))
+#endif
+
+// Output buffers: the shaping exports that run per text (ShapeTextInto, ShapeTextStreamsInto, PrewarmCharsetInto)
+// write into caller-owned buffers and report the required count, returning ShapingOutTooSmall when it doesn't fit.
+// Every other export that returns a buffer allocates it with the context's alloc callback and the given Allocator,
+// those run per font or per atlas update where the callback isn't on the hot path.
 
 using namespace math;
 
@@ -57,6 +66,21 @@ EXPORT_DLL ReturnCode LoadFont(
     return ctx->LoadFont(inFontData, outFontDescription);
 };
 
+/// @brief Loads a font from a file path, the file is memory-mapped so only the tables in use become resident
+/// @param ctx Context
+/// @param inPath UTF-8 path of the font file, not null terminated
+/// @param faceIndex Face index for TrueType collections (.ttc), 0 for single fonts
+/// @param outFontDescription Out font description
+/// @return FontNotFound if the file can't be opened, Failure if it isn't a font or the face doesn't exist
+EXPORT_DLL ReturnCode LoadFontFromFile(
+    Context *ctx,
+    Buffer<char> inPath,
+    int faceIndex,
+    FontDescription *outFontDescription)
+{
+    return ctx->LoadFontFromFile(inPath, faceIndex, outFontDescription);
+};
+
 /// @brief Unloads a font
 /// @param ctx Context
 /// @param font_handle Font index
@@ -85,6 +109,57 @@ EXPORT_DLL ReturnCode ShapeText(
     return ctx->ShapeText(font_handle, allocator, inText, outGlyphs);
 };
 
+/// @brief Shapes a text sample into a caller-owned glyph buffer, call with an empty buffer first to query the required count
+/// @param ctx Context
+/// @param font_handle Font index
+/// @param inText Text sample to shape
+/// @param refGlyphs Destination glyph buffer
+/// @param outCount Number of shaped glyphs, also written when refGlyphs is too small
+/// @return ShapingOutTooSmall if refGlyphs can't hold outCount glyphs
+EXPORT_DLL ReturnCode ShapeTextInto(
+    Context *ctx,
+    FontHandle *font_handle,
+    Buffer<char> *inText,
+    Buffer<GlyphShape> *refGlyphs,
+    int *outCount)
+{
+    return ctx->ShapeTextInto(font_handle, inText, refGlyphs, outCount);
+};
+
+/// @brief Shapes a text sample into structure-of-arrays glyph streams with positions in em
+/// @param ctx Context
+/// @param font_handle Font index
+/// @param allocator Allocator for the stream buffers
+/// @param inText Text sample to shape
+/// @param streams ShapeStream flags, only the requested streams are allocated and filled
+/// @param outStreams Shaped glyph streams
+/// @return
+EXPORT_DLL ReturnCode ShapeTextStreams(
+    Context *ctx,
+    FontHandle *font_handle,
+    Allocator allocator,
+    Buffer<char> *inText,
+    int streams,
+    ShapedGlyphStreams *outStreams)
+{
+    return ctx->ShapeTextStreams(font_handle, allocator, inText, streams, outStreams);
+};
+
+/// @brief Shapes a text sample into caller-owned glyph streams, call with empty streams first to query the required count
+/// @param ctx Context
+/// @param font_handle Font index
+/// @param inText Text sample to shape
+/// @param refStreams Destination streams, streams selects which to fill and count receives the number of shaped glyphs
+/// @return ShapingOutTooSmall if a requested stream can't hold count glyphs
+EXPORT_DLL ReturnCode ShapeTextStreamsInto(
+    Context *ctx,
+    FontHandle *font_handle,
+    Buffer<char> *inText,
+    ShapedGlyphStreams *refStreams)
+{
+    return ctx->ShapeTextStreamsInto(font_handle, inText, refStreams);
+};
+
 /// @brief Fills the glyph metrics buffer with the metrics of the glyphs in the font
 /// @param ctx 
 /// @param font_handle 
@@ -103,13 +178,32 @@ EXPORT_DLL ReturnCode GetGlyphMetrics(
     return ReturnCode::Success;
 }
 
-/// @brief Renders glyphs into the atlas texture using the specified font and rendering configuration
+/// @brief Fills the glyph metrics buffer for the given atlas and render configuration, picks the bitmap metrics when rasterizing bitmaps
 /// @param ctx 
 /// @param font_handle 
 /// @param atlas_config 
 /// @param render_config 
-/// @param in_glyphs 
-/// @param ref_texture 
+/// @param ref_glyphs 
+/// @return 
+EXPORT_DLL ReturnCode GetGlyphAtlasMetrics(
+    Context *ctx,
+    FontHandle *font_handle,
+    AtlasConfig atlas_config,
+    RenderConfig render_config,
+    Buffer<GlyphMetrics> *ref_glyphs)
+{
+    GetRenderGlyphMetrics(*ref_glyphs, font_handle, atlas_config, render_config);
+    return ReturnCode::Success;
+}
+
+/// @brief Renders glyphs into the atlas texture using the specified font and rendering configuration, on the calling
+/// thread so it can run from a job worker. EnqueueGlyphRenders and fontlib-bake are the parallel entry points.
+/// @param ctx 
+/// @param font_handle 
+/// @param atlas_config 
+/// @param render_config 
+/// @param in_glyphs Packed glyphs, glyphs with atlas_page = -1 or an empty tile are skipped
+/// @param ref_texture RGBA32 pixels, or single channel pixels when rasterizing bitmaps
 /// @return 
 EXPORT_DLL ReturnCode RenderGlyphsToAtlas(
     Context *ctx,
@@ -117,14 +211,602 @@ EXPORT_DLL ReturnCode RenderGlyphsToAtlas(
     AtlasConfig atlas_config,
     RenderConfig render_config,
     Buffer<GlyphMetrics> *in_glyphs,
-    Buffer<RGBA32Pixel> *ref_texture)
+    Buffer<byte> *ref_texture)
 {
     for (int i = 0; i < in_glyphs->Count(); i++)
     {
-        RenderGlyph(font_handle, (*in_glyphs)[i], atlas_config, render_config, ref_texture);
+        // Glyphs that weren't packed keep stale coordinates, empty ones have nothing to draw
+        const GlyphMetrics &glyph = (*in_glyphs)[i];
+        if (glyph.atlas_page < 0 || glyph.atlas_width_px <= 0 || glyph.atlas_height_px <= 0)
+            continue;
+        RenderGlyphToAtlas(font_handle, glyph, atlas_config, render_config, ref_texture);
     }
 
     return ReturnCode::Success;
 }
 
+/// @brief Collects the glyphs of codepoint ranges straight from the font's cmap and fills their atlas metrics,
+/// the result can be packed and rendered with RenderGlyphsToAtlas or EnqueueGlyphRenders
+/// @param ctx 
+/// @param font_handle 
+/// @param atlas_config 
+/// @param render_config 
+/// @param in_ranges Codepoint ranges, inclusive
+/// @param flags CharsetFlag, SubstituteClosure adds ligatures and alternates reachable through GSUB
+/// @param allocator Allocator for the output buffer
+/// @param out_glyphs Unique glyphs in ascending index order with their metrics set
+/// @return 
+EXPORT_DLL ReturnCode PrewarmCharset(
+    Context *ctx,
+    FontHandle *font_handle,
+    AtlasConfig atlas_config,
+    RenderConfig render_config,
+    Buffer<UnicodeRange> *in_ranges,
+    int flags,
+    Allocator allocator,
+    Buffer<GlyphMetrics> *out_glyphs)
+{
+    auto charset = CollectCharsetGlyphs(font_handle, in_ranges->Data(), in_ranges->Count(), flags);
+
+    *out_glyphs = ctx->Alloc<GlyphMetrics>(charset.Count(), allocator);
+    int index = 0;
+    charset.ForEach([&](uint32_t glyph)
+                    { (*out_glyphs)[index++] = GlyphMetrics(static_cast<int>(glyph)); });
+
+    GetRenderGlyphMetrics(*out_glyphs, font_handle, atlas_config, render_config);
+    return ReturnCode::Success;
+}
+
+/// @brief PrewarmCharset into a caller-owned buffer, call with an empty buffer first to query the required count
+/// @param ctx 
+/// @param font_handle 
+/// @param atlas_config 
+/// @param render_config 
+/// @param in_ranges Codepoint ranges, inclusive
+/// @param flags CharsetFlag
+/// @param ref_glyphs Destination glyph buffer
+/// @param out_count Number of collected glyphs, also written when ref_glyphs is too small
+/// @return ShapingOutTooSmall if ref_glyphs can't hold out_count glyphs
+EXPORT_DLL ReturnCode PrewarmCharsetInto(
+    Context *ctx,
+    FontHandle *font_handle,
+    AtlasConfig atlas_config,
+    RenderConfig render_config,
+    Buffer<UnicodeRange> *in_ranges,
+    int flags,
+    Buffer<GlyphMetrics> *ref_glyphs,
+    int *out_count)
+{
+    auto charset = CollectCharsetGlyphs(font_handle, in_ranges->Data(), in_ranges->Count(), flags);
+
+    *out_count = charset.Count();
+    if (ref_glyphs == nullptr || ref_glyphs->Count() < *out_count)
+        return ReturnCode::ShapingOutTooSmall;
+
+    int index = 0;
+    charset.ForEach([&](uint32_t glyph)
+                    { (*ref_glyphs)[index++] = GlyphMetrics(static_cast<int>(glyph)); });
+
+    Buffer<GlyphMetrics> glyphs(ref_glyphs->Data(), *out_count * sizeof(GlyphMetrics), Allocator::None);
+    GetRenderGlyphMetrics(glyphs, font_handle, atlas_config, render_config);
+    return ReturnCode::Success;
+}
+
+/// @brief Creates a dynamic glyph atlas with LRU eviction and compaction, several fonts can share it
+/// @param ctx 
+/// @param atlas_config Atlas configuration, flags select the AtlasCompactFlag strategy
+/// @param render_config Render configuration, decides the bytes per pixel
+/// @param max_pages Maximum number of atlas pages
+/// @param out_atlas 
+/// @return 
+EXPORT_DLL ReturnCode CreateGlyphAtlas(
+    Context *ctx,
+    AtlasConfig atlas_config,
+    RenderConfig render_config,
+    int max_pages,
+    GlyphAtlas **out_atlas)
+{
+    if (max_pages <= 0 || atlas_config.size <= 0)
+        return ReturnCode::InvalidArgument;
+
+    *out_atlas = new GlyphAtlas(atlas_config, AtlasBytesPerPixel(render_config), max_pages);
+    return ReturnCode::Success;
+}
+
+/// @brief Destroys a glyph atlas, the page pixel buffers are owned by the caller and left untouched
+/// @param ctx 
+/// @param atlas 
+/// @return 
+EXPORT_DLL ReturnCode DestroyGlyphAtlas(
+    Context *ctx,
+    GlyphAtlas *atlas)
+{
+    delete atlas;
+    return ReturnCode::Success;
+}
+
+/// @brief Sets the pixel buffer of an atlas page, the buffer must stay alive as long as the atlas uses it
+/// @param ctx 
+/// @param atlas 
+/// @param page 
+/// @param pixels 
+/// @return 
+EXPORT_DLL ReturnCode SetGlyphAtlasPage(
+    Context *ctx,
+    GlyphAtlas *atlas,
+    int page,
+    Buffer<byte> pixels)
+{
+    atlas->SetPage(page, pixels);
+    return ReturnCode::Success;
+}
+
+/// @brief Adds glyphs that are already placed and rendered, e.g. from a baked atlas
+/// @param ctx 
+/// @param atlas 
+/// @param font Caller chosen id of the font the glyphs belong to, 0 for atlases with a single font
+/// @param in_glyphs 
+/// @param frame 
+/// @return 
+EXPORT_DLL ReturnCode RegisterAtlasGlyphs(
+    Context *ctx,
+    GlyphAtlas *atlas,
+    int font,
+    Buffer<GlyphMetrics> *in_glyphs,
+    int frame)
+{
+    atlas->Register(font, *in_glyphs, frame);
+    return ReturnCode::Success;
+}
+
+/// @brief Marks glyphs as used in the given frame
+/// @param ctx 
+/// @param atlas 
+/// @param font Font the glyphs belong to
+/// @param in_glyph_indices 
+/// @param frame 
+/// @return 
+EXPORT_DLL ReturnCode TouchAtlasGlyphs(
+    Context *ctx,
+    GlyphAtlas *atlas,
+    int font,
+    Buffer<int32_t> *in_glyph_indices,
+    int frame)
+{
+    atlas->Touch(font, *in_glyph_indices, frame);
+    return ReturnCode::Success;
+}
+
+/// @brief Drops every glyph of a font from a shared atlas and clears its tiles, e.g. before unloading the font.
+/// The space is reclaimed by the next InsertAtlasGlyphs that doesn't fit, its remap reports the tiles it moved
+/// @param ctx 
+/// @param atlas 
+/// @param font 
+/// @param out_count Number of glyphs removed
+/// @return 
+EXPORT_DLL ReturnCode RemoveAtlasFont(
+    Context *ctx,
+    GlyphAtlas *atlas,
+    int font,
+    int *out_count)
+{
+    *out_count = atlas->RemoveFont(font);
+    return ReturnCode::Success;
+}
+
+/// @brief Places glyphs in the atlas, evicting the least recently used glyphs and compacting the pages when they don't fit.
+/// The placed glyphs still have to be rendered with RenderGlyphsToAtlas.
+/// @param ctx 
+/// @param atlas 
+/// @param font Font the glyphs belong to
+/// @param frame Current frame, glyphs used in this frame are never evicted
+/// @param allocator Allocator for the remap buffers
+/// @param ref_glyphs Glyphs with their atlas size set, receive their placement, atlas_page = -1 if they didn't fit
+/// @param out_remap New metrics of previously rendered glyphs of any font that moved, atlas_page = -1 for evicted glyphs, empty if nothing changed
+/// @param out_remap_fonts Font of every glyph in out_remap
+/// @return 
+EXPORT_DLL ReturnCode InsertAtlasGlyphs(
+    Context *ctx,
+    GlyphAtlas *atlas,
+    int font,
+    int frame,
+    Allocator allocator,
+    Buffer<GlyphMetrics> *ref_glyphs,
+    Buffer<GlyphMetrics> *out_remap,
+    Buffer<int32_t> *out_remap_fonts)
+{
+    std::vector<GlyphMetrics> remap;
+    std::vector<int32_t> remap_fonts;
+    atlas->Insert(font, *ref_glyphs, frame, remap, remap_fonts);
+
+    *out_remap = Buffer<GlyphMetrics>();
+    *out_remap_fonts = Buffer<int32_t>();
+    if (!remap.empty())
+    {
+        *out_remap = ctx->Alloc<GlyphMetrics>(static_cast<int>(remap.size()), allocator);
+        std::copy(remap.begin(), remap.end(), out_remap->Data());
+        *out_remap_fonts = ctx->Alloc<int32_t>(static_cast<int>(remap_fonts.size()), allocator);
+        std::copy(remap_fonts.begin(), remap_fonts.end(), out_remap_fonts->Data());
+    }
+    return ReturnCode::Success;
+}
+
+/// @brief Queues glyphs for asynchronous rendering on the context's background workers
+/// @param ctx 
+/// @param font_handle 
+/// @param atlas_config 
+/// @param render_config 
+/// @param priority Higher priorities are rendered first, requests of equal priority in submission order
+/// @param in_glyphs Packed glyphs, copied into the queue
+/// @param texture Atlas page the glyphs are packed into, must stay alive until the glyphs complete or the font is unloaded
+/// @return 
+EXPORT_DLL ReturnCode EnqueueGlyphRenders(
+    Context *ctx,
+    FontHandle *font_handle,
+    AtlasConfig atlas_config,
+    RenderConfig render_config,
+    int priority,
+    Buffer<GlyphMetrics> *in_glyphs,
+    Buffer<byte> texture)
+{
+    ctx->renderQueue.Enqueue(font_handle, atlas_config, render_config, priority, *in_glyphs, texture);
+    return ReturnCode::Success;
+}
+
+/// @brief Returns the glyphs of a font that finished rendering since the last poll
+/// @param ctx 
+/// @param font_handle 
+/// @param allocator Allocator for the output buffer
+/// @param max_count Maximum number of glyphs to return, 0 for all
+/// @param out_glyphs Completed glyphs, empty if none completed
+/// @param out_pending_count Number of glyphs of the font still queued or rendering
+/// @return 
+EXPORT_DLL ReturnCode PollCompletedGlyphs(
+    Context *ctx,
+    FontHandle *font_handle,
+    Allocator allocator,
+    int max_count,
+    Buffer<GlyphMetrics> *out_glyphs,
+    int *out_pending_count)
+{
+    std::vector<GlyphMetrics> completed;
+    ctx->renderQueue.Poll(font_handle, max_count, completed);
+    *out_pending_count = ctx->renderQueue.PendingCount(font_handle);
+
+    *out_glyphs = Buffer<GlyphMetrics>();
+    if (!completed.empty())
+    {
+        *out_glyphs = ctx->Alloc<GlyphMetrics>(static_cast<int>(completed.size()), allocator);
+        std::copy(completed.begin(), completed.end(), out_glyphs->Data());
+    }
+    return ReturnCode::Success;
+}
+
+/// @brief Drops the queued and completed glyphs of a font and waits for the ones being rendered, UnloadFont does this implicitly
+/// @param ctx 
+/// @param font_handle 
+/// @return 
+EXPORT_DLL ReturnCode CancelGlyphRenders(
+    Context *ctx,
+    FontHandle *font_handle)
+{
+    ctx->renderQueue.Cancel(font_handle);
+    return ReturnCode::Success;
+}
+
+/// @brief Builds the vertices of a laid-out text block so it renders as a single mesh, 4 vertices per glyph.
+/// Mixed-style text from fonts sharing a GlyphAtlas builds one mesh by calling this per style run with the run's
+/// glyph table and range.
+/// @param ctx 
+/// @param config Atlas configuration, units per em and font size
+/// @param in_glyph_table Glyph metrics sorted by glyph index, e.g. from PrewarmCharset or a baked atlas. Glyphs with atlas_page = -1 get degenerate quads
+/// @param in_glyphs Placed glyphs of the whole text block
+/// @param first First glyph to rebuild, for partial updates
+/// @param count Number of glyphs to rebuild
+/// @param ref_vertices Vertex buffer of the whole text block, vertices outside the range are left untouched
+/// @return InvalidArgument if the range exceeds the glyphs or the vertex buffer
+EXPORT_DLL ReturnCode BuildTextMesh(
+    Context *ctx,
+    TextMeshConfig config,
+    Buffer<GlyphMetrics> *in_glyph_table,
+    Buffer<GlyphPlacement> *in_glyphs,
+    int first,
+    int count,
+    Buffer<GlyphVertex> *ref_vertices)
+{
+    if (first < 0 || count < 0 || first + count > in_glyphs->Count() || 4 * (first + count) > ref_vertices->Count())
+        return ReturnCode::InvalidArgument;
+    if (config.units_per_em <= 0 || config.atlas_config.glyph_size <= 0 || config.atlas_config.size <= 0)
+        return ReturnCode::InvalidArgument;
+
+    BuildTextMesh(config, *in_glyph_table, *in_glyphs, first, count, *ref_vertices);
+    return ReturnCode::Success;
+}
+
+/// @brief Builds a minimal font holding only the glyphs of a charset, load the result with LoadFont to cut
+/// download size, load time and FontHandle memory for products with a known charset
+/// @param ctx Context
+/// @param inFontData Font file
+/// @param faceIndex Face index for TrueType collections, 0 for single fonts
+/// @param in_ranges Codepoint ranges to keep, inclusive. Ligatures and alternates are kept through the GSUB closure
+/// @param flags SubsetFlag
+/// @param allocator Allocator for the output buffer
+/// @param out_font_data The subset font file
+/// @return Failure if HarfBuzz can't subset the font
+EXPORT_DLL ReturnCode SubsetFont(
+    Context *ctx,
+    Buffer<byte> inFontData,
+    int faceIndex,
+    Buffer<UnicodeRange> *in_ranges,
+    int flags,
+    Allocator allocator,
+    Buffer<byte> *out_font_data)
+{
+    if (in_ranges == nullptr)
+        return ReturnCode::InvalidArgument;
+
+    auto blob = SubsetFontData(inFontData, faceIndex, in_ranges->Data(), in_ranges->Count(), nullptr, 0, flags);
+    if (blob == nullptr)
+        return ReturnCode::Failure;
+
+    unsigned length;
+    const char *data = hb_blob_get_data(blob, &length);
+    *out_font_data = ctx->Alloc<byte>(static_cast<int>(length), allocator);
+    std::memcpy(out_font_data->Data(), data, length);
+    hb_blob_destroy(blob);
+    return ReturnCode::Success;
+}
+
+/// @brief Block compresses a rendered atlas page
+/// @param ctx
+/// @param atlas_config
+/// @param render_config Decides the bytes per pixel of the page
+/// @param compression AtlasCompression, BC4 for single channel pages, BC7 for MSDF and MTSDF
+/// @param in_page Uncompressed page
+/// @param ref_compressed Receives CompressedPageBytes(compression, size) bytes
+/// @param out_report Error against the uncompressed page, may be null
+/// @return InvalidArgument if the page size isn't a multiple of 4 or a buffer is too small
+EXPORT_DLL ReturnCode CompressAtlasPage(
+    Context *ctx,
+    AtlasConfig atlas_config,
+    RenderConfig render_config,
+    int compression,
+    Buffer<byte> *in_page,
+    Buffer<byte> *ref_compressed,
+    CompressionReport *out_report)
+{
+    int size = atlas_config.size;
+    int bytes_per_pixel = AtlasBytesPerPixel(render_config);
+    auto format = static_cast<AtlasCompression>(compression);
+    if (format == AtlasCompression::Uncompressed || size % 4 != 0 ||
+        in_page->SizeInBytes() < size * size * bytes_per_pixel || ref_compressed->SizeInBytes() < CompressedPageBytes(format, size))
+        return ReturnCode::InvalidArgument;
+
+    auto error = CompressAtlasRegion(in_page->Data(), size, bytes_per_pixel, format, 0, 0, size, size, ref_compressed->Data());
+    if (out_report != nullptr)
+        *out_report = MakeCompressionReport(error, (size / 4) * (size / 4));
+    return ReturnCode::Success;
+}
+
+/// @brief Re-encodes only the blocks under the tiles of the given glyphs, e.g. after PollCompletedGlyphs
+/// @param ctx
+/// @param atlas_config
+/// @param render_config
+/// @param compression AtlasCompression the page was compressed with
+/// @param in_glyphs Glyphs on this page whose tiles changed
+/// @param in_page Uncompressed page
+/// @param ref_compressed Compressed page to update
+/// @return InvalidArgument if the page size isn't a multiple of 4 or a buffer is too small
+EXPORT_DLL ReturnCode CompressAtlasGlyphs(
+    Context *ctx,
+    AtlasConfig atlas_config,
+    RenderConfig render_config,
+    int compression,
+    Buffer<GlyphMetrics> *in_glyphs,
+    Buffer<byte> *in_page,
+    Buffer<byte> *ref_compressed)
+{
+    int size = atlas_config.size;
+    int bytes_per_pixel = AtlasBytesPerPixel(render_config);
+    auto format = static_cast<AtlasCompression>(compression);
+    if (format == AtlasCompression::Uncompressed || size % 4 != 0 ||
+        in_page->SizeInBytes() < size * size * bytes_per_pixel || ref_compressed->SizeInBytes() < CompressedPageBytes(format, size))
+        return ReturnCode::InvalidArgument;
+
+    // Neighbouring tiles can share a block, collect every dirty block once
+    int blocks_per_row = size / 4;
+    std::vector<char> dirty(static_cast<size_t>(blocks_per_row) * blocks_per_row, 0);
+    std::vector<int> blocks;
+    for (int i = 0; i < in_glyphs->Count(); i++)
+    {
+        const auto &glyph = (*in_glyphs)[i];
+        int bx1 = std::min(blocks_per_row, (glyph.atlas_x_px + glyph.atlas_width_px + 3) / 4);
+        int by1 = std::min(blocks_per_row, (glyph.atlas_y_px + glyph.atlas_height_px + 3) / 4);
+        for (int by = std::max(0, glyph.atlas_y_px / 4); by < by1; by++)
+        {
+            for (int bx = std::max(0, glyph.atlas_x_px / 4); bx < bx1; bx++)
+            {
+                int block = by * blocks_per_row + bx;
+                if (!dirty[block])
+                {
+                    dirty[block] = 1;
+                    blocks.push_back(block);
+                }
+            }
+        }
+    }
+
+    ParallelFor(static_cast<int>(blocks.size()), [&](int i)
+                {
+                    BlockError error;
+                    EncodeAtlasBlock(in_page->Data(), size, bytes_per_pixel, format, blocks[i] % blocks_per_row, blocks[i] / blocks_per_row, ref_compressed->Data(), error); });
+    return ReturnCode::Success;
+}
+
+/// @brief Reads the unscaled box and advances of many glyphs at once from the font's metrics table, no outline is loaded
+/// @param ctx 
+/// @param font_handle 
+/// @param in_glyphs Glyph indices
+/// @param ref_metrics One entry per glyph index, glyphs outside the font get zero metrics
+/// @return InvalidArgument if ref_metrics is smaller than in_glyphs
+EXPORT_DLL ReturnCode GetGlyphTableMetrics(
+    Context *ctx,
+    FontHandle *font_handle,
+    Buffer<int32_t> *in_glyphs,
+    Buffer<GlyphTableMetrics> *ref_metrics)
+{
+    if (ref_metrics->Count() < in_glyphs->Count())
+        return ReturnCode::InvalidArgument;
+
+    const auto &table = font_handle->MetricsTable();
+    for (int i = 0; i < in_glyphs->Count(); i++)
+    {
+        int32_t index = (*in_glyphs)[i];
+        (*ref_metrics)[i] = index >= 0 && index < static_cast<int32_t>(table.size()) ? table[index] : GlyphTableMetrics{};
+    }
+    return ReturnCode::Success;
+}
+
+/// @brief Triangulates glyph outlines for drawing very large text without atlas tiles. Curves are kept exact through
+/// Loop-Blinn coordinates, see OutlineVertex for the fragment test. Meshes are built on first use and cached on the font.
+/// @param ctx 
+/// @param font_handle 
+/// @param in_glyphs Glyph indices
+/// @param allocator Allocator for the output buffers
+/// @param out_vertices Triangle list of all glyphs, EM-normalized with y up from each glyph's origin
+/// @param out_ranges One range of out_vertices per glyph index
+/// @return 
+EXPORT_DLL ReturnCode GetGlyphOutlineMeshes(
+    Context *ctx,
+    FontHandle *font_handle,
+    Buffer<int32_t> *in_glyphs,
+    Allocator allocator,
+    Buffer<OutlineVertex> *out_vertices,
+    Buffer<OutlineMeshRange> *out_ranges)
+{
+    int count = in_glyphs->Count();
+    std::vector<const std::vector<OutlineVertex> *> meshes(count);
+    ParallelFor(count, [&](int i)
+                { meshes[i] = &LoadOutlineMesh(font_handle, (*in_glyphs)[i]); });
+
+    *out_ranges = ctx->Alloc<OutlineMeshRange>(count, allocator);
+    int vertex_count = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int mesh_count = static_cast<int>(meshes[i]->size());
+        (*out_ranges)[i] = {(*in_glyphs)[i], vertex_count, mesh_count};
+        vertex_count += mesh_count;
+    }
+
+    *out_vertices = ctx->Alloc<OutlineVertex>(vertex_count, allocator);
+    for (int i = 0; i < count; i++)
+        std::copy(meshes[i]->begin(), meshes[i]->end(), out_vertices->Data() + (*out_ranges)[i].first_vertex);
+    return ReturnCode::Success;
+}
+
+/// @brief Bounds the FreeType memory of all fonts of the context. When it's exceeded, the faces and last outlines
+/// of the least recently used fonts are closed, and reopened from the font data on their next use.
+/// @param ctx 
+/// @param max_bytes Budget in bytes, 0 for no limit which is the default
+/// @param out_bytes FreeType memory charged to the fonts after trimming to the budget, may be null
+/// @return InvalidArgument if max_bytes is negative
+EXPORT_DLL ReturnCode SetFaceCacheBudget(
+    Context *ctx,
+    int64_t max_bytes,
+    int64_t *out_bytes)
+{
+    if (max_bytes < 0)
+        return ReturnCode::InvalidArgument;
+
+    ctx->faceCache.SetBudget(max_bytes);
+    if (out_bytes != nullptr)
+        *out_bytes = ctx->faceCache.Bytes();
+    return ReturnCode::Success;
+}
+
+/// @brief Shapes text and builds its cluster map, which answers caret and hit test queries in O(log n)
+/// @param ctx Context
+/// @param font_handle Font index
+/// @param allocator Allocator for the glyph buffer
+/// @param inText UTF-8 text to shape
+/// @param outGlyphs Shaped glyphs, as from ShapeText
+/// @param out_map Cluster map with lines broken after newlines, destroy with DestroyClusterMap
+/// @return
+EXPORT_DLL ReturnCode ShapeTextWithClusterMap(
+    Context *ctx,
+    FontHandle *font_handle,
+    Allocator allocator,
+    Buffer<char> *inText,
+    Buffer<GlyphShape> *outGlyphs,
+    ClusterMap **out_map)
+{
+    return ctx->ShapeTextWithClusterMap(font_handle, allocator, inText, outGlyphs, out_map);
+}
+
+/// @brief Destroys a cluster map
+/// @param ctx 
+/// @param map 
+/// @return 
+EXPORT_DLL ReturnCode DestroyClusterMap(
+    Context *ctx,
+    ClusterMap *map)
+{
+    delete map;
+    return ReturnCode::Success;
+}
+
+/// @brief Sets the lines of a cluster map after wrapping and recomputes its pen positions
+/// @param ctx 
+/// @param map 
+/// @param in_line_starts First glyph of every line after the first in ascending order, empty to break after newlines only
+/// @return InvalidArgument if the line starts aren't ascending
+EXPORT_DLL ReturnCode SetClusterMapLines(
+    Context *ctx,
+    ClusterMap *map,
+    Buffer<int32_t> *in_line_starts)
+{
+    int count = in_line_starts->Count();
+    if (!std::is_sorted(in_line_starts->Data(), in_line_starts->Data() + count))
+        return ReturnCode::InvalidArgument;
+
+    map->SetLines(count > 0 ? in_line_starts->Data() : nullptr, count);
+    return ReturnCode::Success;
+}
+
+/// @brief Finds the caret of a byte offset, carets inside a ligature split its advance evenly
+/// @param ctx 
+/// @param map 
+/// @param byte_offset Byte offset into the shaped text
+/// @param out_caret Pen x and line of the caret, and the glyphs of its cluster
+/// @return 
+EXPORT_DLL ReturnCode GetCaretPosition(
+    Context *ctx,
+    ClusterMap *map,
+    int byte_offset,
+    CaretPosition *out_caret)
+{
+    *out_caret = map->Caret(byte_offset);
+    return ReturnCode::Success;
+}
+
+/// @brief Finds the caret stop nearest to a point of the laid-out text
+/// @param ctx 
+/// @param map 
+/// @param x_em Pen x from the start of the line
+/// @param y_em Distance from the top of the first line, growing downwards
+/// @param line_height_em 
+/// @param out_byte_offset Byte offset of the caret stop
+/// @return 
+EXPORT_DLL ReturnCode HitTestClusterMap(
+    Context *ctx,
+    ClusterMap *map,
+    float x_em,
+    float y_em,
+    float line_height_em,
+    int *out_byte_offset)
+{
+    *out_byte_offset = map->HitTest(x_em, y_em, line_height_em);
+    return ReturnCode::Success;
+}
+
 #endif
\ No newline at end of file
@@ -2,21 +2,672 @@
 #define ATLAS_H
 
 #include <algorithm>
+#include <cstring>
 #include <limits>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <glyph.h>
 #include <buffer.h>
 #include <base.h>
 #include <mathematics.h>
 
+/// @brief Strategies for closing the holes left by evicted glyphs, mirrors AtlasCompactFlags in C#
+enum AtlasCompactFlag
+{
+    FillEnd = 1 << 0, // Slide tiles towards x = margin, free space collects at the end of every row
+    Gravity = 1 << 1, // Slide tiles towards y = margin, free space collects at the top of the page
+    ZigZag = 1 << 2   // Alternate gravity and fill end passes until no tile moves
+};
+
 /// @brief Configuration for the atlas packer.
 struct AtlasConfig
 {
-    int size = 1024;     // Width and Height of the square atlas slice
-    int padding = 0;     // Padding around each glyph in pixels
-    int margin = 1;      // Minimum distance between packed rectangles and the atlas border.
-    int glyph_size = 32; // Size of the glyph in pixels (used for scaling)
-    int flags;
+    int size = 1024;        // Width and Height of the square atlas slice
+    int padding = 0;        // Padding around each glyph in pixels
+    int margin = 1;         // Minimum distance between packed rectangles and the atlas border.
+    int glyph_size = 32;    // Size of the glyph in pixels (used for scaling)
+    int flags;              // AtlasCompactFlag
+    int min_glyph_size = 0; // Adaptive sizing bounds in pixels per em, when both are set every glyph picks
+    int max_glyph_size = 0; // its own size from its outline complexity, see AdaptiveGlyphSize
+};
+
+/// @brief Pixels per em a glyph's tile was sized at
+/// @param glyph
+/// @param config
+/// @return
+inline int GlyphSizePx(const GlyphMetrics &glyph, const AtlasConfig &config)
+{
+    return glyph.glyph_size_px > 0 ? glyph.glyph_size_px : config.glyph_size;
+}
+
+/// @brief Skyline bottom-left packer placing glyph rects into one or more square atlas pages.
+class AtlasPacker
+{
+public:
+    AtlasPacker(AtlasConfig config, int max_pages = 1) : config(config), max_pages(max_pages)
+    {
+        AddPage();
+    }
+
+    int PageCount() const
+    {
+        return static_cast<int>(pages.size());
+    }
+
+    /// @brief Finds a place for a single glyph, opening a new page when the current ones are full
+    /// @param glyph Glyph with its atlas size set, receives the atlas position and page
+    /// @return False if the glyph does not fit in any page
+    bool Pack(GlyphMetrics &glyph)
+    {
+        // Empty glyphs (e.g. spaces) don't need any atlas space
+        if (glyph.atlas_width_px <= 0 || glyph.atlas_height_px <= 0)
+        {
+            glyph.atlas_x_px = 0;
+            glyph.atlas_y_px = 0;
+            glyph.atlas_page = 0;
+            return true;
+        }
+
+        for (int page = 0;; page++)
+        {
+            if (page == PageCount())
+            {
+                if (PageCount() >= max_pages)
+                    break;
+                AddPage();
+            }
+
+            if (PackInPage(page, glyph.atlas_width_px, glyph.atlas_height_px, glyph.atlas_x_px, glyph.atlas_y_px))
+            {
+                glyph.atlas_page = page;
+                return true;
+            }
+        }
+
+        glyph.atlas_page = -1;
+        return false;
+    }
+
+    /// @brief Packs a batch of glyphs, tallest first for a tighter skyline
+    /// @param glyphs Glyphs with their atlas size set, unpacked glyphs get atlas_page = -1
+    /// @return Number of glyphs packed
+    int PackGlyphs(Buffer<GlyphMetrics> glyphs)
+    {
+        std::vector<int> order(glyphs.Count());
+        for (int i = 0; i < glyphs.Count(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+                         { return glyphs[a].atlas_height_px > glyphs[b].atlas_height_px; });
+
+        int packed = 0;
+        for (auto i : order)
+        {
+            if (Pack(glyphs[i]))
+                packed++;
+        }
+        return packed;
+    }
+
+    /// @brief Rebuilds the skyline of a page from the tiles that remain on it, space below the new skyline stays unused
+    /// @param page
+    /// @param tiles Resident tiles of every page, tiles of other pages are ignored
+    void RebuildPage(int page, const std::vector<const GlyphMetrics *> &tiles)
+    {
+        while (PageCount() <= page)
+            AddPage();
+
+        std::vector<int> heights(config.size, config.margin);
+        for (auto tile : tiles)
+        {
+            if (tile->atlas_page != page || tile->atlas_width_px <= 0 || tile->atlas_height_px <= 0)
+                continue;
+            int top = tile->atlas_y_px + tile->atlas_height_px + config.margin;
+            int end = std::min(config.size, tile->atlas_x_px + tile->atlas_width_px + config.margin);
+            for (int x = tile->atlas_x_px; x < end; x++)
+                heights[x] = std::max(heights[x], top);
+        }
+
+        auto &skyline = pages[page];
+        skyline.clear();
+        for (int x = config.margin; x < config.size; x++)
+        {
+            if (!skyline.empty() && skyline.back().y == heights[x])
+                skyline.back().width++;
+            else
+                skyline.push_back(SkylineNode{x, heights[x], 1});
+        }
+    }
+
+private:
+    struct SkylineNode
+    {
+        int x;
+        int y;
+        int width;
+    };
+
+    AtlasConfig config;
+    int max_pages;
+    std::vector<std::vector<SkylineNode>> pages;
+
+    void AddPage()
+    {
+        pages.push_back({SkylineNode{config.margin, config.margin, config.size - config.margin}});
+    }
+
+    /// @brief Returns the y at which a rect of the given size can sit on the skyline starting at node_index, or -1 if it doesn't fit
+    int Fit(const std::vector<SkylineNode> &skyline, size_t node_index, int width, int height) const
+    {
+        int x = skyline[node_index].x;
+        if (x + width > config.size)
+            return -1;
+
+        int y = skyline[node_index].y;
+        int width_left = width;
+        size_t i = node_index;
+        while (width_left > 0)
+        {
+            if (i >= skyline.size())
+                return -1;
+            y = std::max(y, skyline[i].y);
+            if (y + height > config.size)
+                return -1;
+            width_left -= skyline[i].width;
+            i++;
+        }
+        return y;
+    }
+
+    bool PackInPage(int page, int width, int height, int &out_x, int &out_y)
+    {
+        auto &skyline = pages[page];
+
+        // Each rect reserves the margin on its right and bottom side, the first row and column start at the margin
+        int spaced_width = width + config.margin;
+        int spaced_height = height + config.margin;
+
+        int best_index = -1;
+        int best_bottom = std::numeric_limits<int>::max();
+        int best_width = std::numeric_limits<int>::max();
+        int best_y = 0;
+        for (size_t i = 0; i < skyline.size(); i++)
+        {
+            int y = Fit(skyline, i, spaced_width, spaced_height);
+            if (y < 0)
+                continue;
+
+            int bottom = y + spaced_height;
+            if (bottom < best_bottom || (bottom == best_bottom && skyline[i].width < best_width))
+            {
+                best_index = static_cast<int>(i);
+                best_bottom = bottom;
+                best_width = skyline[i].width;
+                best_y = y;
+            }
+        }
+
+        if (best_index < 0)
+            return false;
+
+        out_x = skyline[best_index].x;
+        out_y = best_y;
+
+        // Insert the new node and shrink the nodes it now covers
+        SkylineNode node{out_x, best_bottom, spaced_width};
+        skyline.insert(skyline.begin() + best_index, node);
+        for (size_t i = best_index + 1; i < skyline.size();)
+        {
+            int covered = node.x + node.width - skyline[i].x;
+            if (covered <= 0)
+                break;
+
+            if (covered >= skyline[i].width)
+            {
+                skyline.erase(skyline.begin() + i);
+                continue;
+            }
+
+            skyline[i].x += covered;
+            skyline[i].width -= covered;
+            break;
+        }
+
+        // Merge neighbours of the same height
+        for (size_t i = 0; i + 1 < skyline.size();)
+        {
+            if (skyline[i].y == skyline[i + 1].y)
+            {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+                continue;
+            }
+            i++;
+        }
+
+        return true;
+    }
+};
+
+/// @brief Dynamic glyph atlas that keeps track of when each glyph was last used.
+/// When an insert doesn't fit, the least recently used glyphs are evicted and the remaining tiles are
+/// compacted by moving their pixels, so already rendered glyphs never have to be rendered again.
+/// Several fonts can share one atlas, e.g. the regular, bold and italic faces of a family so mixed-style text
+/// renders with one material. Glyphs are resident per (font, glyph index), the font being a caller chosen id,
+/// and all fonts pack into the same pages and compete for the same LRU eviction.
+class GlyphAtlas
+{
+public:
+    GlyphAtlas(AtlasConfig config, int bytes_per_pixel, int max_pages)
+        : config(config), bytes_per_pixel(bytes_per_pixel), packer(config, max_pages), pages(max_pages)
+    {
+    }
+
+    /// @brief Sets the pixel buffer of a page, required for pages that hold rendered tiles to be compacted
+    /// @param page
+    /// @param pixels size * size * bytes_per_pixel bytes
+    void SetPage(int page, Buffer<byte> pixels)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (page >= 0 && page < static_cast<int>(pages.size()))
+            pages[page] = pixels;
+    }
+
+    /// @brief Adds glyphs that are already placed and rendered, e.g. from a baked atlas
+    /// @param font Font the glyphs belong to
+    /// @param glyphs
+    /// @param frame
+    void Register(int font, Buffer<GlyphMetrics> glyphs, int frame)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &glyph : glyphs)
+        {
+            if (glyph.atlas_page >= 0)
+                entries[Key(font, glyph.index)] = Entry{glyph, frame, font};
+        }
+        RebuildSkylines();
+    }
+
+    /// @brief Marks glyphs as used in the given frame, glyphs used in the current frame are never evicted
+    /// @param font Font the glyphs belong to
+    /// @param glyph_indices
+    /// @param frame
+    void Touch(int font, Buffer<int32_t> glyph_indices, int frame)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto index : glyph_indices)
+        {
+            auto it = entries.find(Key(font, index));
+            if (it != entries.end())
+                it->second.last_used = frame;
+        }
+    }
+
+    /// @brief Places glyphs in the atlas. When they don't fit, the holes left by removed fonts are compacted first,
+    /// then the least recently used glyphs are evicted and compacted.
+    /// Glyphs that are already resident receive their current placement.
+    /// @param font Font the glyphs belong to
+    /// @param glyphs Glyphs with their atlas size set, receive their placement, atlas_page = -1 if they didn't fit
+    /// @param frame Current frame, glyphs used in this frame are never evicted
+    /// @param remap Receives the new metrics of previously resident glyphs that moved, evicted glyphs have atlas_page = -1.
+    /// These can belong to any font of the atlas.
+    /// @param remap_fonts Receives the font of every remapped glyph
+    /// @return Number of glyphs placed
+    int Insert(int font, Buffer<GlyphMetrics> glyphs, int frame, std::vector<GlyphMetrics> &remap, std::vector<int32_t> &remap_fonts)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::vector<int> pending;
+        std::vector<int64_t> inserted;
+        for (int i = 0; i < glyphs.Count(); i++)
+        {
+            auto it = entries.find(Key(font, glyphs[i].index));
+            if (it != entries.end())
+            {
+                it->second.last_used = frame;
+                continue;
+            }
+
+            if (packer.Pack(glyphs[i]))
+            {
+                entries[Key(font, glyphs[i].index)] = Entry{glyphs[i], frame, font};
+                inserted.push_back(Key(font, glyphs[i].index));
+            }
+            else
+            {
+                pending.push_back(i);
+            }
+        }
+
+        if (!pending.empty())
+        {
+            // Remember where the rendered tiles were so moved ones can be reported
+            std::unordered_map<int64_t, GlyphMetrics> before;
+            for (auto &pair : entries)
+                before.emplace(pair.first, pair.second.metrics);
+            for (auto key : inserted)
+                before.erase(key);
+
+            while (!pending.empty())
+            {
+                if (fragmented)
+                {
+                    // Close the holes left by RemoveFont before evicting anything
+                    Compact();
+                }
+                else
+                {
+                    int64_t needed_area = 0;
+                    for (auto i : pending)
+                        needed_area += static_cast<int64_t>(glyphs[i].atlas_width_px + config.margin) * (glyphs[i].atlas_height_px + config.margin);
+
+                    if (!Evict(frame, needed_area, before))
+                        break;
+                    Compact();
+                }
+
+                std::vector<int> still_pending;
+                for (auto i : pending)
+                {
+                    if (packer.Pack(glyphs[i]))
+                    {
+                        entries[Key(font, glyphs[i].index)] = Entry{glyphs[i], frame, font};
+                        before.erase(Key(font, glyphs[i].index));
+                    }
+                    else
+                        still_pending.push_back(i);
+                }
+                pending.swap(still_pending);
+            }
+
+            for (auto &pair : before)
+            {
+                auto it = entries.find(pair.first);
+                if (it == entries.end())
+                {
+                    GlyphMetrics evicted = pair.second;
+                    evicted.atlas_page = -1;
+                    remap.push_back(evicted);
+                    remap_fonts.push_back(FontOf(pair.first));
+                }
+                else if (Moved(pair.second, it->second.metrics))
+                {
+                    remap.push_back(it->second.metrics);
+                    remap_fonts.push_back(it->second.font);
+                }
+            }
+        }
+
+        // Compaction may have moved the new glyphs as well
+        int placed = 0;
+        for (auto &glyph : glyphs)
+        {
+            auto it = entries.find(Key(font, glyph.index));
+            if (it == entries.end())
+            {
+                glyph.atlas_page = -1;
+                continue;
+            }
+            glyph = it->second.metrics;
+            placed++;
+        }
+        return placed;
+    }
+
+    /// @brief Drops every glyph of a font and clears its tiles, e.g. when the font is unloaded. The tiles of the other
+    /// fonts don't move here, the next insert that doesn't fit compacts the pages to reclaim the freed space and
+    /// reports the moved tiles in its remap.
+    /// @param font
+    /// @return Number of glyphs removed
+    int RemoveFont(int font)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        int removed = 0;
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second.font != font)
+            {
+                ++it;
+                continue;
+            }
+            auto &glyph = it->second.metrics;
+            ClearRect(glyph.atlas_page, glyph.atlas_x_px, glyph.atlas_y_px, glyph.atlas_width_px, glyph.atlas_height_px);
+            it = entries.erase(it);
+            removed++;
+        }
+        if (removed > 0)
+        {
+            RebuildSkylines();
+            fragmented = true;
+        }
+        return removed;
+    }
+
+private:
+    struct Entry
+    {
+        GlyphMetrics metrics;
+        int last_used;
+        int font;
+    };
+
+    AtlasConfig config;
+    int bytes_per_pixel;
+    AtlasPacker packer;
+    std::vector<Buffer<byte>> pages;
+    std::unordered_map<int64_t, Entry> entries; // Keyed by Key(font, glyph index)
+    bool fragmented = false;                    // RemoveFont left holes below the skylines
+    std::mutex mutex;
+
+    static int64_t Key(int font, int glyph_index)
+    {
+        return (static_cast<int64_t>(font) << 32) | static_cast<uint32_t>(glyph_index);
+    }
+
+    static int FontOf(int64_t key)
+    {
+        return static_cast<int>(key >> 32);
+    }
+
+    static bool IsEmpty(const GlyphMetrics &glyph)
+    {
+        return glyph.atlas_width_px <= 0 || glyph.atlas_height_px <= 0;
+    }
+
+    static bool Moved(const GlyphMetrics &a, const GlyphMetrics &b)
+    {
+        return a.atlas_page != b.atlas_page || a.atlas_x_px != b.atlas_x_px || a.atlas_y_px != b.atlas_y_px;
+    }
+
+    byte *PagePixels(int page)
+    {
+        if (page < 0 || page >= static_cast<int>(pages.size()))
+            return nullptr;
+        return pages[page].Data();
+    }
+
+    /// @brief Evicts the least recently used rendered glyphs until at least needed_area pixels are freed
+    /// @return False if nothing could be evicted
+    bool Evict(int frame, int64_t needed_area, const std::unordered_map<int64_t, GlyphMetrics> &rendered)
+    {
+        std::vector<std::pair<const int64_t, Entry> *> candidates;
+        for (auto &pair : entries)
+        {
+            if (pair.second.last_used < frame && !IsEmpty(pair.second.metrics) && rendered.count(pair.first))
+                candidates.push_back(&pair);
+        }
+        if (candidates.empty())
+            return false;
+
+        std::sort(candidates.begin(), candidates.end(), [](const std::pair<const int64_t, Entry> *a, const std::pair<const int64_t, Entry> *b)
+                  { return a->second.last_used < b->second.last_used; });
+
+        std::vector<int64_t> evicted;
+        int64_t freed_area = 0;
+        for (auto candidate : candidates)
+        {
+            if (freed_area >= needed_area)
+                break;
+            auto &glyph = candidate->second.metrics;
+            freed_area += static_cast<int64_t>(glyph.atlas_width_px + config.margin) * (glyph.atlas_height_px + config.margin);
+            ClearRect(glyph.atlas_page, glyph.atlas_x_px, glyph.atlas_y_px, glyph.atlas_width_px, glyph.atlas_height_px);
+            evicted.push_back(candidate->first);
+        }
+
+        for (auto key : evicted)
+            entries.erase(key);
+        return true;
+    }
+
+    /// @brief Closes the holes left by evicted glyphs with the configured strategy and rebuilds the skylines
+    void Compact()
+    {
+        for (int page = 0; page < packer.PageCount(); page++)
+        {
+            std::vector<GlyphMetrics *> tiles;
+            for (auto &pair : entries)
+            {
+                if (pair.second.metrics.atlas_page == page && !IsEmpty(pair.second.metrics))
+                    tiles.push_back(&pair.second.metrics);
+            }
+
+            if (Flag::has(config.flags, AtlasCompactFlag::ZigZag))
+            {
+                // Bounded, each pass only ever moves tiles towards the origin
+                for (int pass = 0; pass < 8; pass++)
+                {
+                    bool moved = Slide(tiles, true);
+                    moved |= Slide(tiles, false);
+                    if (!moved)
+                        break;
+                }
+            }
+            else
+            {
+                if (Flag::has(config.flags, AtlasCompactFlag::Gravity))
+                    Slide(tiles, true);
+                if (Flag::has(config.flags, AtlasCompactFlag::FillEnd))
+                    Slide(tiles, false);
+            }
+        }
+
+        RebuildSkylines();
+        fragmented = false;
+    }
+
+    /// @brief Slides every tile of a page as far as it goes towards y = margin (vertical) or x = margin.
+    /// Tiles are processed in order of their position along the axis so a tile only ever moves into space
+    /// that no unprocessed tile occupies, which keeps the in-place pixel moves safe.
+    /// @return True if any tile moved
+    bool Slide(std::vector<GlyphMetrics *> &tiles, bool vertical)
+    {
+        std::sort(tiles.begin(), tiles.end(), [vertical](const GlyphMetrics *a, const GlyphMetrics *b)
+                  { return vertical ? std::make_pair(a->atlas_y_px, a->atlas_x_px) < std::make_pair(b->atlas_y_px, b->atlas_x_px)
+                                    : std::make_pair(a->atlas_x_px, a->atlas_y_px) < std::make_pair(b->atlas_x_px, b->atlas_y_px); });
+
+        bool moved = false;
+        for (size_t i = 0; i < tiles.size(); i++)
+        {
+            auto tile = tiles[i];
+            int target = config.margin;
+            for (size_t j = 0; j < i; j++)
+            {
+                auto placed = tiles[j];
+                if (vertical)
+                {
+                    bool overlaps = placed->atlas_x_px < tile->atlas_x_px + tile->atlas_width_px + config.margin &&
+                                    tile->atlas_x_px < placed->atlas_x_px + placed->atlas_width_px + config.margin;
+                    if (overlaps)
+                        target = std::max(target, placed->atlas_y_px + placed->atlas_height_px + config.margin);
+                }
+                else
+                {
+                    bool overlaps = placed->atlas_y_px < tile->atlas_y_px + tile->atlas_height_px + config.margin &&
+                                    tile->atlas_y_px < placed->atlas_y_px + placed->atlas_height_px + config.margin;
+                    if (overlaps)
+                        target = std::max(target, placed->atlas_x_px + placed->atlas_width_px + config.margin);
+                }
+            }
+
+            int current = vertical ? tile->atlas_y_px : tile->atlas_x_px;
+            if (target < current)
+            {
+                MoveTile(*tile, vertical ? tile->atlas_x_px : target, vertical ? target : tile->atlas_y_px);
+                moved = true;
+            }
+        }
+        return moved;
+    }
+
+    /// @brief Moves the pixels of a tile within its page and clears the area it left behind
+    void MoveTile(GlyphMetrics &tile, int x, int y)
+    {
+        byte *pixels = PagePixels(tile.atlas_page);
+        if (pixels != nullptr)
+        {
+            size_t stride = static_cast<size_t>(config.size) * bytes_per_pixel;
+            size_t row_bytes = static_cast<size_t>(tile.atlas_width_px) * bytes_per_pixel;
+            auto row = [&](int r)
+            {
+                memmove(pixels + (y + r) * stride + x * bytes_per_pixel,
+                        pixels + (tile.atlas_y_px + r) * stride + tile.atlas_x_px * bytes_per_pixel,
+                        row_bytes);
+            };
+
+            // Copy rows in the order that never overwrites a source row before it is read
+            if (y <= tile.atlas_y_px)
+                for (int r = 0; r < tile.atlas_height_px; r++)
+                    row(r);
+            else
+                for (int r = tile.atlas_height_px - 1; r >= 0; r--)
+                    row(r);
+
+            // Clear the part of the old rect the new rect doesn't cover
+            for (int r = tile.atlas_y_px; r < tile.atlas_y_px + tile.atlas_height_px; r++)
+            {
+                bool row_covered = r >= y && r < y + tile.atlas_height_px;
+                if (!row_covered)
+                {
+                    ClearRect(tile.atlas_page, tile.atlas_x_px, r, tile.atlas_width_px, 1);
+                    continue;
+                }
+                int left = tile.atlas_x_px;
+                int right = tile.atlas_x_px + tile.atlas_width_px;
+                if (x > left)
+                    ClearRect(tile.atlas_page, left, r, std::min(x, right) - left, 1);
+                if (x + tile.atlas_width_px < right)
+                    ClearRect(tile.atlas_page, std::max(x + tile.atlas_width_px, left), r, right - std::max(x + tile.atlas_width_px, left), 1);
+            }
+        }
+
+        tile.atlas_x_px = x;
+        tile.atlas_y_px = y;
+    }
+
+    void ClearRect(int page, int x, int y, int width, int height)
+    {
+        byte *pixels = PagePixels(page);
+        if (pixels == nullptr || width <= 0 || height <= 0)
+            return;
+
+        size_t stride = static_cast<size_t>(config.size) * bytes_per_pixel;
+        for (int r = y; r < y + height; r++)
+            memset(pixels + r * stride + x * bytes_per_pixel, 0, static_cast<size_t>(width) * bytes_per_pixel);
+    }
+
+    void RebuildSkylines()
+    {
+        std::vector<const GlyphMetrics *> tiles;
+        tiles.reserve(entries.size());
+        int page_count = packer.PageCount();
+        for (auto &pair : entries)
+        {
+            tiles.push_back(&pair.second.metrics);
+            page_count = std::max(page_count, pair.second.metrics.atlas_page + 1);
+        }
+        for (int page = 0; page < page_count; page++)
+            packer.RebuildPage(page, tiles);
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,285 @@
+#ifndef BAKE_H
+#define BAKE_H
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "context.h"
+#include "parallel.h"
+
+const char BAKED_ATLAS_MAGIC[4] = {'F', 'L', 'B', 'A'};
+const int32_t BAKED_ATLAS_VERSION = 4;
+
+/// @brief Header of a baked atlas file, followed by glyph_count GlyphMetrics and page_count pages of size * size pixels,
+/// or of CompressedPageBytes(compression, size) bytes for compressed atlases.
+/// All fields are 4 bytes wide so the layout matches the sequential C# struct.
+struct BakedAtlasHeader
+{
+    char magic[4];
+    int32_t version;
+    AtlasConfig atlas_config;
+    RenderConfig render_config;
+    int32_t units_per_em;
+    int32_t ascender;
+    int32_t descender;
+    int32_t height;
+    int32_t glyph_count;
+    int32_t page_count;
+    int32_t bytes_per_pixel;
+    int32_t compression; // AtlasCompression
+};
+
+/// @brief A single font and configuration combination to bake
+struct BakeVariant
+{
+    FontDescription *font;
+    AtlasConfig atlas_config;
+    RenderConfig render_config;
+    std::string output_path;
+    int max_pages = 1;
+    AtlasCompression compression = AtlasCompression::Uncompressed;
+
+    std::vector<GlyphMetrics> glyphs;
+    std::vector<byte> pixels; // Compressed blocks once CompressBakeVariant ran
+    int page_count = 0;
+    int packed_count = 0;
+    CompressionReport report = {};
+
+    Buffer<byte> Page(int page)
+    {
+        int page_bytes = atlas_config.size * atlas_config.size * AtlasBytesPerPixel(render_config);
+        return Buffer<byte>(pixels.data() + static_cast<size_t>(page) * page_bytes, page_bytes, Allocator::None);
+    }
+};
+
+/// @brief Collects the unique glyph indices required for the given codepoint ranges and text samples
+/// @param ctx
+/// @param font_handle
+/// @param ranges Codepoint ranges, mapped through the font's cmap and closed over GSUB
+/// @param samples UTF-8 text shaped with the font, picks up ligatures and alternates
+/// @return Sorted unique glyph indices
+std::vector<int> CollectGlyphIndices(Context *ctx, FontHandle *font_handle, const std::vector<UnicodeRange> &ranges, const std::string &samples)
+{
+    std::vector<int> indices;
+    auto charset = CollectCharsetGlyphs(font_handle, ranges.data(), static_cast<int>(ranges.size()), CharsetFlag::SubstituteClosure);
+    charset.ForEach([&](uint32_t glyph)
+                    { indices.push_back(static_cast<int>(glyph)); });
+
+    if (!samples.empty())
+    {
+        Buffer<char> text((void *)samples.data(), static_cast<int32_t>(samples.size()), Allocator::None);
+        auto shaped = ctx->ShapeText(font_handle, &text);
+        indices.insert(indices.end(), shaped.begin(), shaped.end());
+    }
+
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return indices;
+}
+
+/// @brief Computes the metrics of the variant's glyphs and packs them into atlas pages
+/// @param variant
+/// @param glyph_indices
+void PackBakeVariant(BakeVariant &variant, const std::vector<int> &glyph_indices)
+{
+    variant.glyphs.assign(glyph_indices.begin(), glyph_indices.end());
+    Buffer<GlyphMetrics> glyphs(variant.glyphs.data(), static_cast<int32_t>(variant.glyphs.size() * sizeof(GlyphMetrics)), Allocator::None);
+    GetRenderGlyphMetrics(glyphs, variant.font->font_handle, variant.atlas_config, variant.render_config);
+
+    AtlasPacker packer(variant.atlas_config, variant.max_pages);
+    variant.packed_count = packer.PackGlyphs(glyphs);
+    variant.page_count = packer.PageCount();
+
+    // Glyphs that didn't fit are left out of the baked table
+    variant.glyphs.erase(
+        std::remove_if(variant.glyphs.begin(), variant.glyphs.end(), [](const GlyphMetrics &glyph)
+                       { return glyph.atlas_page < 0; }),
+        variant.glyphs.end());
+
+    variant.pixels.assign(static_cast<size_t>(variant.page_count) * variant.atlas_config.size * variant.atlas_config.size * AtlasBytesPerPixel(variant.render_config), 0);
+}
+
+/// @brief Renders all glyphs of all variants, spreading the glyphs of every variant over all threads
+/// @param variants Packed variants
+/// @param thread_count Number of threads, 0 uses all hardware threads
+void RenderBakeVariants(std::vector<BakeVariant> &variants, int thread_count)
+{
+    struct RenderTask
+    {
+        int variant;
+        int glyph;
+    };
+
+    std::vector<RenderTask> tasks;
+    for (int v = 0; v < static_cast<int>(variants.size()); v++)
+    {
+        for (int g = 0; g < static_cast<int>(variants[v].glyphs.size()); g++)
+            tasks.push_back({v, g});
+    }
+
+    ParallelFor(static_cast<int>(tasks.size()), [&](int i)
+                {
+                    auto &variant = variants[tasks[i].variant];
+                    auto &glyph = variant.glyphs[tasks[i].glyph];
+                    if (glyph.atlas_width_px <= 0 || glyph.atlas_height_px <= 0)
+                        return;
+                    auto page = variant.Page(glyph.atlas_page);
+                    RenderGlyphToAtlas(variant.font->font_handle, glyph, variant.atlas_config, variant.render_config, &page); },
+                thread_count);
+}
+
+/// @brief Writes a subset of a font that keeps the baked glyphs, glyph ids are retained so the baked atlases of the
+/// full font stay valid for the subset
+/// @param font_data Font file
+/// @param ranges Codepoint ranges, kept in the subset's cmap
+/// @param samples UTF-8 text samples, their codepoints are kept in the subset's cmap
+/// @param glyph_indices Baked glyphs
+/// @param flags SubsetFlag, RetainGlyphIds is always added
+/// @param output_path
+/// @return Size of the subset font in bytes, 0 on failure
+size_t WriteSubsetFont(Buffer<byte> font_data, const std::vector<UnicodeRange> &ranges, const std::string &samples, const std::vector<int> &glyph_indices, int flags, const std::string &output_path)
+{
+    std::vector<UnicodeRange> codepoints = ranges;
+    if (!samples.empty())
+    {
+        // Decode the samples with HarfBuzz, the buffer holds codepoints until it is shaped
+        auto buffer = hb_buffer_create();
+        hb_buffer_add_utf8(buffer, samples.data(), static_cast<int>(samples.size()), 0, -1);
+        unsigned count;
+        hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(buffer, &count);
+        for (unsigned i = 0; i < count; i++)
+            codepoints.push_back({static_cast<int32_t>(infos[i].codepoint), static_cast<int32_t>(infos[i].codepoint)});
+        hb_buffer_destroy(buffer);
+    }
+
+    auto blob = SubsetFontData(font_data, 0, codepoints.data(), static_cast<int>(codepoints.size()), glyph_indices.data(), static_cast<int>(glyph_indices.size()), flags | SubsetFlag::RetainGlyphIds);
+    if (blob == nullptr)
+        return 0;
+
+    unsigned length;
+    const char *data = hb_blob_get_data(blob, &length);
+    std::ofstream file(output_path, std::ios::binary | std::ios::trunc);
+    file.write(data, length);
+    hb_blob_destroy(blob);
+    return file.good() ? length : 0;
+}
+
+/// @brief Replaces the rendered pages of a variant with their block compressed form
+/// @param variant Rendered variant
+/// @param thread_count Number of threads, 0 uses all hardware threads
+void CompressBakeVariant(BakeVariant &variant, int thread_count)
+{
+    if (variant.compression == AtlasCompression::Uncompressed)
+        return;
+
+    int size = variant.atlas_config.size;
+    int bytes_per_pixel = AtlasBytesPerPixel(variant.render_config);
+    int page_bytes = CompressedPageBytes(variant.compression, size);
+    std::vector<byte> compressed(static_cast<size_t>(variant.page_count) * page_bytes);
+
+    BlockError error;
+    for (int page = 0; page < variant.page_count; page++)
+    {
+        error.Merge(CompressAtlasRegion(variant.Page(page).Data(), size, bytes_per_pixel, variant.compression, 0, 0, size, size,
+                                        compressed.data() + static_cast<size_t>(page) * page_bytes, thread_count));
+    }
+
+    variant.report = MakeCompressionReport(error, variant.page_count * (size / 4) * (size / 4));
+    variant.pixels = std::move(compressed);
+}
+
+/// @brief Timings of msdfgen against GenerateLinearField on the same shapes
+struct LinearFieldBenchmark
+{
+    int glyph_count = 0;
+    double msdfgen_seconds = 0;
+    double kernel_seconds = 0;
+    float max_error = 0; // Largest difference of a channel, in 8-bit levels
+};
+
+/// @brief Generates the MTSDF of every glyph of a packed variant from its resolved, all-linear shape, once with msdfgen
+/// and once with GenerateLinearField, on the calling thread. Error correction is left out of the timings.
+/// @param variant Packed variant
+/// @return
+LinearFieldBenchmark BenchmarkLinearField(const BakeVariant &variant)
+{
+    using Clock = std::chrono::steady_clock;
+    LinearFieldBenchmark result;
+    FontHandle *font_handle = variant.font->font_handle;
+    float range = variant.render_config.distance_mapping_range;
+    msdfgen::MSDFGeneratorConfig config(false, msdfgen::ErrorCorrectionConfig(msdfgen::ErrorCorrectionConfig::DISABLED));
+
+    for (const auto &glyph : variant.glyphs)
+    {
+        if (glyph.atlas_width_px <= 0 || glyph.atlas_height_px <= 0)
+            continue;
+
+        DecomposeData decompose_data;
+        {
+            auto lock = font_handle->Lock();
+            DecomposeOutline(font_handle->Outline(glyph.index), decompose_data);
+        }
+        msdfgen::Shape shape = ResolveDecomposedShape(decompose_data, font_handle->units_per_em);
+        edgeColoringSimple(shape, 3.0);
+
+        float scale = static_cast<float>(GlyphSizePx(glyph, variant.atlas_config));
+        msdfgen::Shape::Bounds bounds = shape.getBounds();
+        msdfgen::Vector2 translate((variant.atlas_config.padding - bounds.l * scale) / scale, (variant.atlas_config.padding - bounds.b * scale) / scale);
+        msdfgen::SDFTransformation transform(msdfgen::Projection(scale, translate), msdfgen::Range(range));
+        msdfgen::Bitmap<float, 4> reference(glyph.atlas_width_px, glyph.atlas_height_px);
+        msdfgen::Bitmap<float, 4> bitmap(glyph.atlas_width_px, glyph.atlas_height_px);
+
+        auto start = Clock::now();
+        msdfgen::generateMTSDF(reference, shape, transform, config);
+        auto middle = Clock::now();
+        if (!GenerateLinearField<4>(bitmap, shape, scale, translate, range, transform, config))
+            continue;
+        auto end = Clock::now();
+
+        result.glyph_count++;
+        result.msdfgen_seconds += std::chrono::duration<double>(middle - start).count();
+        result.kernel_seconds += std::chrono::duration<double>(end - middle).count();
+        for (int y = 0; y < glyph.atlas_height_px; y++)
+        {
+            for (int x = 0; x < glyph.atlas_width_px; x++)
+            {
+                for (int c = 0; c < 4; c++)
+                    result.max_error = std::max(result.max_error, 255.0f * fabsf(clamp(reference(x, y)[c]) - clamp(bitmap(x, y)[c])));
+            }
+        }
+    }
+    return result;
+}
+
+/// @brief Writes a rendered variant to its output path
+/// @param variant
+/// @return False if the file could not be written
+bool WriteBakedAtlas(const BakeVariant &variant)
+{
+    std::ofstream file(variant.output_path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    BakedAtlasHeader header = {};
+    std::copy(std::begin(BAKED_ATLAS_MAGIC), std::end(BAKED_ATLAS_MAGIC), header.magic);
+    header.version = BAKED_ATLAS_VERSION;
+    header.atlas_config = variant.atlas_config;
+    header.render_config = variant.render_config;
+    header.units_per_em = variant.font->units_per_em;
+    header.ascender = variant.font->ascender;
+    header.descender = variant.font->descender;
+    header.height = variant.font->height;
+    header.glyph_count = static_cast<int32_t>(variant.glyphs.size());
+    header.page_count = variant.page_count;
+    header.bytes_per_pixel = AtlasBytesPerPixel(variant.render_config);
+    header.compression = variant.compression;
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(variant.glyphs.data()), variant.glyphs.size() * sizeof(GlyphMetrics));
+    file.write(reinterpret_cast<const char *>(variant.pixels.data()), variant.pixels.size());
+    return file.good();
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef BASE_H
 #define BASE_H
 
+#include <stdint.h>
+
 typedef unsigned char byte;
 
 namespace Flag
@@ -11,4 +13,14 @@ namespace Flag
     }
 }
 
+inline uint32_t ReadUInt32BE(const byte *p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline uint16_t ReadUInt16BE(const byte *p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
 #endif
\ No newline at end of file
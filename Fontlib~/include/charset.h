@@ -0,0 +1,117 @@
+#ifndef CHARSET_H
+#define CHARSET_H
+
+#include <algorithm>
+#include <bitset>
+#include <stdint.h>
+#include <vector>
+#include "hb.h"
+#include "hb-ot.h"
+#include "font.h"
+#include "glyph.h"
+
+enum CharsetFlag
+{
+    SubstituteClosure = 1 << 0 // Also collect ligatures and alternates reachable through GSUB
+};
+
+/// @brief Dense set of glyph ids, one bit per glyph of the font
+class GlyphBitset
+{
+public:
+    GlyphBitset(int glyph_count) : words((glyph_count + 63) / 64, 0), glyph_count(glyph_count) {}
+
+    void Set(uint32_t glyph)
+    {
+        if (glyph < static_cast<uint32_t>(glyph_count))
+            words[glyph >> 6] |= uint64_t(1) << (glyph & 63);
+    }
+
+    bool Has(uint32_t glyph) const
+    {
+        return glyph < static_cast<uint32_t>(glyph_count) && (words[glyph >> 6] >> (glyph & 63)) & 1;
+    }
+
+    int Count() const
+    {
+        int count = 0;
+        for (auto word : words)
+            count += static_cast<int>(std::bitset<64>(word).count());
+        return count;
+    }
+
+    /// @brief Calls fn(glyph) for every set glyph in ascending order
+    template <typename F>
+    void ForEach(F &&fn) const
+    {
+        for (size_t w = 0; w < words.size(); w++)
+        {
+            uint64_t word = words[w];
+            for (int bit = 0; word != 0; bit++, word >>= 1)
+            {
+                if (word & 1)
+                    fn(static_cast<uint32_t>(w * 64 + bit));
+            }
+        }
+    }
+
+private:
+    std::vector<uint64_t> words;
+    int glyph_count;
+};
+
+/// @brief Maps codepoint ranges straight through the font's cmap into a glyph set, no shaping involved
+/// @param font_handle
+/// @param ranges
+/// @param range_count
+/// @param flags CharsetFlag
+/// @return
+GlyphBitset CollectCharsetGlyphs(FontHandle *font_handle, const UnicodeRange *ranges, int range_count, int flags)
+{
+    hb_face_t *face = hb_font_get_face(font_handle->hb);
+    GlyphBitset glyphs(static_cast<int>(hb_face_get_glyph_count(face)));
+
+    // hb_font_get_nominal_glyphs stops at the first unmapped codepoint, resume right after it
+    const unsigned chunk_size = 256;
+    hb_codepoint_t codepoints[chunk_size];
+    hb_codepoint_t mapped[chunk_size];
+    for (int r = 0; r < range_count; r++)
+    {
+        for (int64_t start = ranges[r].start; start <= ranges[r].end; start += chunk_size)
+        {
+            unsigned count = static_cast<unsigned>(std::min<int64_t>(chunk_size, ranges[r].end - start + 1));
+            for (unsigned i = 0; i < count; i++)
+                codepoints[i] = static_cast<hb_codepoint_t>(start + i);
+
+            for (unsigned offset = 0; offset < count;)
+            {
+                unsigned done = hb_font_get_nominal_glyphs(font_handle->hb, count - offset, codepoints + offset, sizeof(hb_codepoint_t), mapped + offset, sizeof(hb_codepoint_t));
+                for (unsigned i = 0; i < done; i++)
+                    glyphs.Set(mapped[offset + i]);
+                offset += done + 1;
+            }
+        }
+    }
+
+    if (Flag::has(flags, CharsetFlag::SubstituteClosure))
+    {
+        hb_set_t *glyph_set = hb_set_create();
+        hb_set_t *lookups = hb_set_create();
+        glyphs.ForEach([&](uint32_t glyph)
+                       { hb_set_add(glyph_set, glyph); });
+
+        hb_ot_layout_collect_lookups(face, HB_OT_TAG_GSUB, nullptr, nullptr, nullptr, lookups);
+        hb_ot_layout_lookups_substitute_closure(face, lookups, glyph_set);
+
+        hb_codepoint_t glyph = HB_SET_VALUE_INVALID;
+        while (hb_set_next(glyph_set, &glyph))
+            glyphs.Set(glyph);
+
+        hb_set_destroy(lookups);
+        hb_set_destroy(glyph_set);
+    }
+
+    return glyphs;
+}
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef CLUSTER_MAP_H
+#define CLUSTER_MAP_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+#include "hb.h"
+
+/// @brief Caret of a byte offset in shaped text
+struct CaretPosition
+{
+    float x_em;          // Pen x from the start of the line
+    int32_t line;
+    int32_t first_glyph; // Glyphs of the cluster holding the caret
+    int32_t glyph_count;
+};
+
+/// @brief Maps the byte offsets of a shaped left-to-right text to its glyphs and pen positions, so caret placement
+/// and hit testing are binary searches instead of walks over the glyphs. Clusters covering several characters, e.g.
+/// ligatures, get one caret stop per character with the cluster's advance split evenly between them. Marks don't
+/// get caret stops of their own.
+class ClusterMap
+{
+public:
+    struct Span
+    {
+        int32_t byte_start; // Cluster value, bytes up to the next cluster belong to it
+        int32_t byte_end;
+        int32_t first_glyph;
+        int32_t glyph_count;
+        int32_t first_caret; // Index into caret_bytes
+        int32_t caret_count;
+        int32_t line;
+        float x_em;       // Pen x from the start of the line
+        float advance_em; // Zero for line breaks
+        bool line_break;
+    };
+
+    std::vector<Span> spans;             // Sorted by byte_start
+    std::vector<int32_t> caret_bytes;    // Byte offsets of the caret stops, sorted
+    std::vector<int32_t> caret_spans;    // Span of each caret stop
+    std::vector<int32_t> line_first_span; // Lines are contiguous runs of spans
+    int32_t text_length = 0;
+
+    /// @brief Builds the spans and caret stops of shaped text, lines break after newlines until SetLines is called
+    /// @param text UTF-8 text the buffer was shaped from
+    /// @param length Length of the text in bytes
+    /// @param infos Shaped glyphs, clusters are byte offsets into the text
+    /// @param positions
+    /// @param glyph_count
+    /// @param to_em Scale from font units to em
+    void Build(const char *text, int length, const hb_glyph_info_t *infos, const hb_glyph_position_t *positions, int glyph_count, float to_em)
+    {
+        spans.clear();
+        caret_bytes.clear();
+        caret_spans.clear();
+        text_length = length;
+
+        // Left-to-right clusters are monotonic, a glyph going back is merged into the span before it
+        for (int i = 0; i < glyph_count; i++)
+        {
+            int32_t cluster = static_cast<int32_t>(infos[i].cluster);
+            if (spans.empty() || cluster > spans.back().byte_start)
+                spans.push_back({cluster, 0, i, 0, 0, 0, 0, 0.0f, 0.0f, false});
+            Span &span = spans.back();
+            span.glyph_count = i + 1 - span.first_glyph;
+            span.advance_em += positions[i].x_advance * to_em;
+        }
+
+        hb_unicode_funcs_t *unicode = hb_unicode_funcs_get_default();
+        for (size_t s = 0; s < spans.size(); s++)
+        {
+            Span &span = spans[s];
+            span.byte_end = s + 1 < spans.size() ? spans[s + 1].byte_start : length;
+            span.line_break = span.byte_start < length && text[span.byte_start] == '\n';
+            if (span.line_break)
+                span.advance_em = 0.0f;
+
+            // One stop per character, the cluster start always gets one
+            span.first_caret = static_cast<int32_t>(caret_bytes.size());
+            int32_t byte = span.byte_start;
+            while (byte < span.byte_end)
+            {
+                int32_t next;
+                hb_codepoint_t codepoint = DecodeUtf8(text, span.byte_end, byte, next);
+                auto category = hb_unicode_general_category(unicode, codepoint);
+                bool mark = category == HB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK ||
+                            category == HB_UNICODE_GENERAL_CATEGORY_SPACING_MARK ||
+                            category == HB_UNICODE_GENERAL_CATEGORY_ENCLOSING_MARK;
+                if (byte == span.byte_start || !mark)
+                {
+                    caret_bytes.push_back(byte);
+                    caret_spans.push_back(static_cast<int32_t>(s));
+                }
+                byte = next;
+            }
+            span.caret_count = static_cast<int32_t>(caret_bytes.size()) - span.first_caret;
+        }
+
+        SetLines(nullptr, 0);
+    }
+
+    /// @brief Lays the spans out on lines and recomputes the pen positions
+    /// @param line_starts First glyph of every line after the first, ascending, e.g. from line wrapping. Null breaks
+    /// lines after newlines only.
+    /// @param line_count Number of entries in line_starts
+    void SetLines(const int32_t *line_starts, int line_count)
+    {
+        line_first_span.clear();
+        int32_t line = 0;
+        float x = 0.0f;
+        for (size_t s = 0; s < spans.size(); s++)
+        {
+            Span &span = spans[s];
+            int32_t span_line = line;
+            if (line_starts != nullptr)
+                span_line = static_cast<int32_t>(std::upper_bound(line_starts, line_starts + line_count, span.first_glyph) - line_starts);
+            else if (s > 0 && spans[s - 1].line_break)
+                span_line = line + 1;
+
+            if (s == 0 || span_line != line)
+            {
+                // Lines without spans of their own, e.g. wrap points inside a cluster, share the next span
+                while (static_cast<int32_t>(line_first_span.size()) <= span_line)
+                    line_first_span.push_back(static_cast<int32_t>(s));
+                line = span_line;
+                x = 0.0f;
+            }
+            span.line = line;
+            span.x_em = x;
+            x += span.advance_em;
+        }
+    }
+
+    /// @brief Finds the caret of a byte offset
+    /// @param byte_offset Clamped to the text, offsets inside a character snap to its start
+    /// @return
+    CaretPosition Caret(int32_t byte_offset) const
+    {
+        if (spans.empty())
+            return CaretPosition{};
+
+        if (byte_offset >= text_length)
+        {
+            // After the last character, which is on a line of its own behind a trailing newline
+            const Span &last = spans.back();
+            if (last.line_break)
+                return {0.0f, last.line + 1, last.first_glyph + last.glyph_count, 0};
+            return {last.x_em + last.advance_em, last.line, last.first_glyph, last.glyph_count};
+        }
+
+        auto it = std::upper_bound(caret_bytes.begin(), caret_bytes.end(), std::max(byte_offset, 0));
+        int32_t caret = std::max(static_cast<int32_t>(it - caret_bytes.begin()) - 1, 0);
+        const Span &span = spans[caret_spans[caret]];
+        float fraction = static_cast<float>(caret - span.first_caret) / span.caret_count;
+        return {span.x_em + span.advance_em * fraction, span.line, span.first_glyph, span.glyph_count};
+    }
+
+    /// @brief Finds the caret stop nearest to a point
+    /// @param x_em Pen x from the start of the line
+    /// @param y_em Distance from the top of the first line, growing downwards
+    /// @param line_height_em
+    /// @return Byte offset of the caret stop
+    int32_t HitTest(float x_em, float y_em, float line_height_em) const
+    {
+        if (spans.empty())
+            return 0;
+
+        int32_t lines = static_cast<int32_t>(line_first_span.size());
+        int32_t line = line_height_em > 0.0f ? static_cast<int32_t>(std::floor(y_em / line_height_em)) : 0;
+        if (line >= lines && spans.back().line_break)
+            return text_length;
+        line = std::min(std::max(line, 0), lines - 1);
+
+        auto first = spans.begin() + line_first_span[line];
+        auto last = line + 1 < lines ? spans.begin() + line_first_span[line + 1] : spans.end();
+        if (first == last)
+            return first != spans.end() ? first->byte_start : text_length;
+
+        // First span that ends past the point
+        auto it = std::upper_bound(first, last, x_em, [](float x, const Span &span)
+                                   { return x < span.x_em + span.advance_em; });
+        if (it == last)
+        {
+            const Span &end = *(last - 1);
+            return end.line_break ? end.byte_start : end.byte_end;
+        }
+
+        const Span &span = *it;
+        if (span.line_break || span.advance_em <= 0.0f)
+            return span.byte_start;
+        int32_t stop = static_cast<int32_t>(std::lround((x_em - span.x_em) / span.advance_em * span.caret_count));
+        stop = std::min(std::max(stop, 0), span.caret_count);
+        return stop == span.caret_count ? span.byte_end : caret_bytes[span.first_caret + stop];
+    }
+
+private:
+    // Decodes the character at byte, invalid sequences decode as single bytes
+    static hb_codepoint_t DecodeUtf8(const char *text, int32_t end, int32_t byte, int32_t &next)
+    {
+        const unsigned char *s = reinterpret_cast<const unsigned char *>(text);
+        unsigned char lead = s[byte];
+        int length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 1;
+        if (byte + length > end)
+            length = 1;
+        hb_codepoint_t codepoint = length == 1 ? lead : lead & (0x7F >> length);
+        for (int i = 1; i < length; i++)
+        {
+            if ((s[byte + i] & 0xC0) != 0x80)
+            {
+                next = byte + 1;
+                return lead;
+            }
+            codepoint = (codepoint << 6) | (s[byte + i] & 0x3F);
+        }
+        next = byte + length;
+        return codepoint;
+    }
+};
+
+#endif
@@ -0,0 +1,393 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+#include "base.h"
+#include "parallel.h"
+
+/// @brief Block compressed formats for atlas pages, mirrors AtlasCompression in C#
+enum AtlasCompression
+{
+    Uncompressed = 0,
+    BC4 = 1, // One channel, 8 bytes per 4x4 block. SDF, PSDF and bitmap pages
+    BC5 = 2, // First two channels as two BC4 blocks, 16 bytes per 4x4 block
+    BC7 = 3  // RGBA, 16 bytes per 4x4 block. MSDF and MTSDF pages, encoded with mode 6
+};
+
+/// @brief Error of a compressed page against the uncompressed pixels, over all encoded channels
+struct CompressionReport
+{
+    float rmse;
+    float psnr;      // In dB, 0 when the encoding is lossless
+    int max_error;   // Largest absolute difference of a single channel value
+    int block_count; // Number of 4x4 blocks encoded
+};
+
+inline int CompressedBlockBytes(AtlasCompression compression)
+{
+    return compression == AtlasCompression::BC4 ? 8 : 16;
+}
+
+/// @brief Size in bytes of a compressed square page
+/// @param compression
+/// @param size Page width and height, a multiple of 4
+/// @return
+inline int CompressedPageBytes(AtlasCompression compression, int size)
+{
+    return (size / 4) * (size / 4) * CompressedBlockBytes(compression);
+}
+
+/// @brief Compression that fits the channel count of a page
+/// @param bytes_per_pixel
+/// @return
+inline AtlasCompression DefaultCompression(int bytes_per_pixel)
+{
+    return bytes_per_pixel == 1 ? AtlasCompression::BC4 : AtlasCompression::BC7;
+}
+
+/// @brief Squared and maximum error accumulated while encoding
+struct BlockError
+{
+    uint64_t squared = 0;
+    int max = 0;
+    int64_t samples = 0;
+
+    void Add(int a, int b)
+    {
+        int d = std::abs(a - b);
+        squared += static_cast<uint64_t>(d * d);
+        max = std::max(max, d);
+        samples++;
+    }
+
+    void Merge(const BlockError &other)
+    {
+        squared += other.squared;
+        max = std::max(max, other.max);
+        samples += other.samples;
+    }
+};
+
+/// @brief Encodes 16 single-channel values as a BC4 block, using the 8 level mode
+/// @param values Pixels of the block in row order
+/// @param out 8 bytes
+/// @param error Receives the error of the decoded block
+void EncodeBC4Block(const uint8_t values[16], uint8_t out[8], BlockError &error)
+{
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        lo = std::min<int>(lo, values[i]);
+        hi = std::max<int>(hi, values[i]);
+    }
+
+    // Levels ordered from e0 (hi) to e1 (lo): index 0, 2, 3, 4, 5, 6, 7, 1
+    static const int level_to_index[8] = {0, 2, 3, 4, 5, 6, 7, 1};
+    out[0] = static_cast<uint8_t>(hi);
+    out[1] = static_cast<uint8_t>(lo);
+    uint64_t bits = 0;
+    int range = hi - lo;
+    for (int i = 0; i < 16; i++)
+    {
+        int level = range > 0 ? ((hi - values[i]) * 7 + range / 2) / range : 0;
+        int decoded = ((7 - level) * hi + level * lo + 3) / 7;
+        error.Add(values[i], decoded);
+        bits |= static_cast<uint64_t>(level_to_index[level]) << (3 * i);
+    }
+
+    for (int b = 0; b < 6; b++)
+        out[2 + b] = static_cast<uint8_t>(bits >> (8 * b));
+}
+
+/// @brief Writes the lowest count bits of value at a bit position of a little endian block
+inline void PutBits(uint8_t *block, int &position, uint32_t value, int count)
+{
+    for (int i = 0; i < count; i++, position++)
+    {
+        if ((value >> i) & 1)
+            block[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+    }
+}
+
+static const int BC7_WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+inline int BC7Interpolate(int e0, int e1, int weight)
+{
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+/// @brief Candidate mode 6 encoding, endpoints are 7 bits per channel plus one shared p-bit per endpoint
+struct BC7Mode6Candidate
+{
+    int endpoints[2][4]; // 7-bit values
+    int pbits[2];
+    uint8_t indices[16];
+    uint64_t error = UINT64_MAX;
+
+    int Endpoint(int e, int c) const { return (endpoints[e][c] << 1) | pbits[e]; }
+};
+
+/// @brief Quantizes float endpoints for every p-bit pair and picks the indices with the least error
+void FitBC7Mode6(const uint8_t pixels[16][4], const float e0[4], const float e1[4], BC7Mode6Candidate &best)
+{
+    for (int p = 0; p < 4; p++)
+    {
+        BC7Mode6Candidate candidate;
+        candidate.pbits[0] = p & 1;
+        candidate.pbits[1] = p >> 1;
+        for (int c = 0; c < 4; c++)
+        {
+            candidate.endpoints[0][c] = std::min(127, std::max(0, static_cast<int>(std::lround((e0[c] - candidate.pbits[0]) * 0.5f))));
+            candidate.endpoints[1][c] = std::min(127, std::max(0, static_cast<int>(std::lround((e1[c] - candidate.pbits[1]) * 0.5f))));
+        }
+
+        int palette[16][4];
+        for (int w = 0; w < 16; w++)
+        {
+            for (int c = 0; c < 4; c++)
+                palette[w][c] = BC7Interpolate(candidate.Endpoint(0, c), candidate.Endpoint(1, c), BC7_WEIGHTS_4[w]);
+        }
+
+        candidate.error = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            uint32_t best_distance = UINT32_MAX;
+            for (int w = 0; w < 16; w++)
+            {
+                uint32_t distance = 0;
+                for (int c = 0; c < 4; c++)
+                {
+                    int d = palette[w][c] - pixels[i][c];
+                    distance += static_cast<uint32_t>(d * d);
+                }
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    candidate.indices[i] = static_cast<uint8_t>(w);
+                }
+            }
+            candidate.error += best_distance;
+        }
+
+        if (candidate.error < best.error)
+            best = candidate;
+    }
+}
+
+/// @brief Encodes 16 RGBA pixels as a BC7 mode 6 block. Distance fields are smooth inside a block, so a single
+/// subset with 4-bit indices along the principal axis keeps most of the precision without partition search.
+/// @param pixels Pixels of the block in row order
+/// @param channels Channels present in the source, missing channels are encoded as 255
+/// @param out 16 bytes
+/// @param error Receives the error of the decoded block over the source channels
+void EncodeBC7Block(const uint8_t pixels[16][4], int channels, uint8_t out[16], BlockError &error)
+{
+    // Principal axis of the block colors through power iteration on the covariance
+    float mean[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 4; c++)
+            mean[c] += pixels[i][c] / 16.0f;
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; i++)
+    {
+        for (int a = 0; a < 4; a++)
+        {
+            for (int b = 0; b < 4; b++)
+                covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+        }
+    }
+
+    float axis[4] = {1, 1, 1, 1};
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4] = {0, 0, 0, 0};
+        for (int a = 0; a < 4; a++)
+        {
+            for (int b = 0; b < 4; b++)
+                next[a] += covariance[a][b] * axis[b];
+        }
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < 4; c++)
+            axis[c] = next[c] / length;
+    }
+
+    float t_min = 0.0f, t_max = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        float t = 0.0f;
+        for (int c = 0; c < 4; c++)
+            t += (pixels[i][c] - mean[c]) * axis[c];
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+    }
+
+    float e0[4], e1[4];
+    for (int c = 0; c < 4; c++)
+    {
+        e0[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * t_min));
+        e1[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * t_max));
+    }
+
+    BC7Mode6Candidate best;
+    FitBC7Mode6(pixels, e0, e1, best);
+
+    // One least squares refit of the endpoints to the chosen indices
+    float a00 = 0, a01 = 0, a11 = 0;
+    float b0[4] = {0, 0, 0, 0}, b1[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 16; i++)
+    {
+        float t = BC7_WEIGHTS_4[best.indices[i]] / 64.0f;
+        a00 += (1 - t) * (1 - t);
+        a01 += (1 - t) * t;
+        a11 += t * t;
+        for (int c = 0; c < 4; c++)
+        {
+            b0[c] += (1 - t) * pixels[i][c];
+            b1[c] += t * pixels[i][c];
+        }
+    }
+    float determinant = a00 * a11 - a01 * a01;
+    if (std::fabs(determinant) > 1e-6f)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            e0[c] = std::min(255.0f, std::max(0.0f, (a11 * b0[c] - a01 * b1[c]) / determinant));
+            e1[c] = std::min(255.0f, std::max(0.0f, (a00 * b1[c] - a01 * b0[c]) / determinant));
+        }
+        FitBC7Mode6(pixels, e0, e1, best);
+    }
+
+    // The most significant bit of the first index is implicit zero, swap the endpoints when it is set
+    if (best.indices[0] & 8)
+    {
+        for (int c = 0; c < 4; c++)
+            std::swap(best.endpoints[0][c], best.endpoints[1][c]);
+        std::swap(best.pbits[0], best.pbits[1]);
+        for (int i = 0; i < 16; i++)
+            best.indices[i] = static_cast<uint8_t>(15 - best.indices[i]);
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < channels; c++)
+            error.Add(pixels[i][c], BC7Interpolate(best.Endpoint(0, c), best.Endpoint(1, c), BC7_WEIGHTS_4[best.indices[i]]));
+    }
+
+    std::fill(out, out + 16, 0);
+    int position = 0;
+    PutBits(out, position, 1 << 6, 7);
+    for (int c = 0; c < 4; c++)
+    {
+        PutBits(out, position, best.endpoints[0][c], 7);
+        PutBits(out, position, best.endpoints[1][c], 7);
+    }
+    PutBits(out, position, best.pbits[0], 1);
+    PutBits(out, position, best.pbits[1], 1);
+    PutBits(out, position, best.indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        PutBits(out, position, best.indices[i], 4);
+}
+
+/// @brief Encodes a single 4x4 block of a page
+/// @param pixels Uncompressed page, size * size pixels of bytes_per_pixel bytes
+/// @param size Page width and height, a multiple of 4
+/// @param bytes_per_pixel 1, 3 or 4
+/// @param compression
+/// @param bx Block column
+/// @param by Block row
+/// @param out Compressed page of CompressedPageBytes(compression, size) bytes
+/// @param error Receives the error of the block
+void EncodeAtlasBlock(const byte *pixels, int size, int bytes_per_pixel, AtlasCompression compression, int bx, int by, byte *out, BlockError &error)
+{
+    uint8_t block[16][4];
+    for (int py = 0; py < 4; py++)
+    {
+        const byte *src = pixels + (static_cast<size_t>(by * 4 + py) * size + bx * 4) * bytes_per_pixel;
+        for (int px = 0; px < 4; px++)
+        {
+            for (int c = 0; c < 4; c++)
+                block[py * 4 + px][c] = c < bytes_per_pixel ? src[px * bytes_per_pixel + c] : 255;
+        }
+    }
+
+    byte *dst = out + (static_cast<size_t>(by) * (size / 4) + bx) * CompressedBlockBytes(compression);
+    if (compression == AtlasCompression::BC7)
+    {
+        EncodeBC7Block(block, bytes_per_pixel, dst, error);
+        return;
+    }
+
+    // BC4 and BC5 encode the first one and two channels independently
+    int channel_count = compression == AtlasCompression::BC5 ? 2 : 1;
+    for (int c = 0; c < channel_count; c++)
+    {
+        uint8_t values[16];
+        for (int i = 0; i < 16; i++)
+            values[i] = block[i][std::min(c, bytes_per_pixel - 1)];
+        EncodeBC4Block(values, dst + 8 * c, error);
+    }
+}
+
+/// @brief Encodes the 4x4 blocks of a page that overlap a rectangle, blocks outside it are left untouched so
+/// dirty tiles can be re-encoded on their own
+/// @param pixels Uncompressed page, size * size pixels of bytes_per_pixel bytes
+/// @param size Page width and height, a multiple of 4
+/// @param bytes_per_pixel 1, 3 or 4
+/// @param compression
+/// @param x Rectangle in pixels
+/// @param y
+/// @param width
+/// @param height
+/// @param out Compressed page of CompressedPageBytes(compression, size) bytes
+/// @param thread_count Number of threads, 0 uses all hardware threads
+/// @return Error of the encoded blocks
+BlockError CompressAtlasRegion(const byte *pixels, int size, int bytes_per_pixel, AtlasCompression compression, int x, int y, int width, int height, byte *out, int thread_count = 0)
+{
+    int blocks_per_row = size / 4;
+    int bx0 = std::max(0, x / 4);
+    int by0 = std::max(0, y / 4);
+    int bx1 = std::min(blocks_per_row, (x + width + 3) / 4);
+    int by1 = std::min(blocks_per_row, (y + height + 3) / 4);
+    if (bx1 <= bx0 || by1 <= by0)
+        return BlockError();
+
+    std::vector<BlockError> row_errors(by1 - by0);
+    ParallelFor(by1 - by0, [&](int row)
+                {
+                    for (int bx = bx0; bx < bx1; bx++)
+                        EncodeAtlasBlock(pixels, size, bytes_per_pixel, compression, bx, by0 + row, out, row_errors[row]); },
+                thread_count);
+
+    BlockError error;
+    for (auto &row_error : row_errors)
+        error.Merge(row_error);
+    return error;
+}
+
+/// @brief Converts accumulated errors into a report
+/// @param error
+/// @param block_count
+/// @return
+CompressionReport MakeCompressionReport(const BlockError &error, int block_count)
+{
+    CompressionReport report = {};
+    report.block_count = block_count;
+    report.max_error = error.max;
+    if (error.samples > 0)
+    {
+        double mse = static_cast<double>(error.squared) / error.samples;
+        report.rmse = static_cast<float>(std::sqrt(mse));
+        report.psnr = mse > 0.0 ? static_cast<float>(10.0 * std::log10(255.0 * 255.0 / mse)) : 0.0f;
+    }
+    return report;
+}
+
+#endif
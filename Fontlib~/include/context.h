@@ -8,11 +8,21 @@
 #include "buffer.h"
 #include "shape.h"
 #include "render.h"
+#include "queue.h"
+#include "charset.h"
+#include "cluster_map.h"
+#include "mesh.h"
+#include "subset.h"
+#include "compress.h"
 #include "error.h"
 #include "hb.h"
 #include <log.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
+#include <cstring>
+#include <set>
+#include <string>
 #include <vector>
 #include <sstream>
 #include <stdexcept>
@@ -21,30 +31,53 @@ class Context
 {
 public:
     FT_Library ftLib;
+    FaceCache faceCache;
     AllocCallback allocCallback;
     DisposeCallback disposeCallback;
     LogCallback logCallback;
+    GlyphRenderQueue renderQueue;
     Context(LogCallback logCallback, AllocCallback allocCallback, DisposeCallback disposeCallback)
     {
         this->logCallback = logCallback;
         this->allocCallback = allocCallback;
         this->disposeCallback = disposeCallback;
-        FT_Init_FreeType(&ftLib);
+        // Same setup as FT_Init_FreeType, with the allocations going through the face cache
+        FT_New_Library(faceCache.Memory(), &ftLib);
+        FT_Add_Default_Modules(ftLib);
+        FT_Set_Default_Properties(ftLib);
     }
 
     ~Context()
     {
-        FT_Done_FreeType(ftLib);
+        // Workers may still be using faces of this library
+        renderQueue.Shutdown();
+        FT_Done_Library(ftLib);
     }
 
     ReturnCode LoadFont(Buffer<byte> inFontData, FontDescription *outFontDescription)
     {
-        *outFontDescription = FontDescription(ftLib, inFontData);
+        *outFontDescription = FontDescription(new FontHandle(ftLib, inFontData, &faceCache));
+        return Success;
+    }
+
+    ReturnCode LoadFontFromFile(Buffer<char> inPath, int faceIndex, FontDescription *outFontDescription)
+    {
+        auto font_handle = new FontHandle();
+        auto result = font_handle->OpenFile(ftLib, std::string(inPath.Data(), inPath.Count()), faceIndex, &faceCache);
+        if (result != Success)
+        {
+            Log() << "Failed to open font file " << std::string(inPath.Data(), inPath.Count()) << "\n";
+            delete font_handle;
+            return result;
+        }
+
+        *outFontDescription = FontDescription(font_handle);
         return Success;
     }
 
     ReturnCode UnloadFont(FontHandle *font_handle)
     {
+        renderQueue.Cancel(font_handle);
         font_handle->Dispose();
         return Success;
     }
@@ -52,12 +85,7 @@ public:
     ReturnCode ShapeText(FontHandle *font_handle, Allocator allocator, Buffer<char> *inText, Buffer<GlyphShape> *outGlyphs)
     {
         // Shape the text
-        auto buffer = hb_buffer_create();
-        hb_buffer_add_utf8(buffer, inText->Data(), inText->SizeInBytes(), 0, inText->SizeInBytes());
-        hb_buffer_set_direction(buffer, HB_DIRECTION_LTR);
-        hb_buffer_set_script(buffer, HB_SCRIPT_LATIN);
-        hb_buffer_set_language(buffer, hb_language_from_string("en", -1));
-        hb_shape(font_handle->hb, buffer, nullptr, 0);
+        auto buffer = ShapeBuffer(font_handle, inText);
 
         // Get glyph info and positions
         unsigned int glyphCount;
@@ -72,16 +100,7 @@ public:
 
         // Write glyph data
         *outGlyphs = Alloc<GlyphShape>(glyphCount, allocator);
-        for (unsigned int i = 0; i < glyphCount; ++i)
-        {
-            auto ptr = &(*outGlyphs)[i];
-            ptr->codepoint = glyphInfo[i].codepoint;
-            ptr->cluster = glyphInfo[i].cluster;
-            ptr->offset_x_fu = glyphPos[i].x_offset;
-            ptr->offset_y_fu = glyphPos[i].y_offset;
-            ptr->advance_x_fu = glyphPos[i].x_advance;
-            ptr->advance_y_fu = glyphPos[i].y_advance;
-        }
+        WriteGlyphShapes(glyphInfo, glyphPos, glyphCount, outGlyphs->Data());
 
         // Clean up
         hb_buffer_destroy(buffer);
@@ -89,15 +108,36 @@ public:
         return ReturnCode::Success;
     }
 
+    /// @brief ShapeText that also builds the cluster map of the text for caret placement and hit testing
+    /// @param font_handle
+    /// @param allocator
+    /// @param inText UTF-8 text
+    /// @param outGlyphs
+    /// @param outClusterMap Lines break after newlines, see ClusterMap::SetLines for wrapped text
+    /// @return
+    ReturnCode ShapeTextWithClusterMap(FontHandle *font_handle, Allocator allocator, Buffer<char> *inText, Buffer<GlyphShape> *outGlyphs, ClusterMap **outClusterMap)
+    {
+        auto buffer = ShapeBuffer(font_handle, inText);
+
+        unsigned int glyphCount;
+        hb_glyph_info_t *glyphInfo = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+        hb_glyph_position_t *glyphPos = hb_buffer_get_glyph_positions(buffer, &glyphCount);
+
+        *outGlyphs = Alloc<GlyphShape>(glyphCount, allocator);
+        WriteGlyphShapes(glyphInfo, glyphPos, glyphCount, outGlyphs->Data());
+
+        float to_em = 1.0f / static_cast<float>(hb_face_get_upem(hb_font_get_face(font_handle->hb)));
+        *outClusterMap = new ClusterMap();
+        (*outClusterMap)->Build(inText->Data(), inText->SizeInBytes(), glyphInfo, glyphPos, static_cast<int>(glyphCount), to_em);
+
+        hb_buffer_destroy(buffer);
+        return ReturnCode::Success;
+    }
+
     std::vector<int> ShapeText(FontHandle *font_handle, Buffer<char> *inText)
     {
         // Shape the text
-        auto buffer = hb_buffer_create();
-        hb_buffer_add_utf8(buffer, inText->Data(), inText->SizeInBytes(), 0, inText->SizeInBytes());
-        hb_buffer_set_direction(buffer, HB_DIRECTION_LTR);
-        hb_buffer_set_script(buffer, HB_SCRIPT_LATIN);
-        hb_buffer_set_language(buffer, hb_language_from_string("en", -1));
-        hb_shape(font_handle->hb, buffer, nullptr, 0);
+        auto buffer = ShapeBuffer(font_handle, inText);
 
         // Get glyph info and positions
         unsigned int glyphCount;
@@ -116,6 +156,98 @@ public:
         return result;
     }
 
+    /// @brief Shapes text into a caller-owned buffer, nothing is allocated through the alloc callback
+    /// @param font_handle
+    /// @param inText UTF-8 text
+    /// @param refGlyphs Destination, may be null or empty to only query the required count
+    /// @param outCount Number of shaped glyphs, also written when the destination is too small
+    /// @return ShapingOutTooSmall if refGlyphs can't hold outCount glyphs
+    ReturnCode ShapeTextInto(FontHandle *font_handle, Buffer<char> *inText, Buffer<GlyphShape> *refGlyphs, int *outCount)
+    {
+        auto buffer = ShapeCached(font_handle, inText);
+
+        unsigned int glyphCount;
+        hb_glyph_info_t *glyphInfo = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+        hb_glyph_position_t *glyphPos = hb_buffer_get_glyph_positions(buffer, &glyphCount);
+
+        *outCount = static_cast<int>(glyphCount);
+        if (refGlyphs == nullptr || refGlyphs->Count() < static_cast<int>(glyphCount))
+            return ReturnCode::ShapingOutTooSmall;
+
+        WriteGlyphShapes(glyphInfo, glyphPos, glyphCount, refGlyphs->Data());
+        return ReturnCode::Success;
+    }
+
+    /// @brief Shapes text into structure-of-arrays streams with positions scaled to em
+    /// @param font_handle
+    /// @param allocator Allocator for the stream buffers
+    /// @param inText UTF-8 text
+    /// @param streams ShapeStream flags of the streams to produce
+    /// @param outStreams
+    /// @return
+    ReturnCode ShapeTextStreams(FontHandle *font_handle, Allocator allocator, Buffer<char> *inText, int streams, ShapedGlyphStreams *outStreams)
+    {
+        auto buffer = ShapeBuffer(font_handle, inText);
+
+        unsigned int glyphCount;
+        hb_glyph_info_t *glyphInfo = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+        hb_glyph_position_t *glyphPos = hb_buffer_get_glyph_positions(buffer, &glyphCount);
+        int count = static_cast<int>(glyphCount);
+
+        *outStreams = ShapedGlyphStreams();
+        outStreams->count = count;
+        outStreams->streams = streams;
+        if (Flag::has(streams, ShapeStream::GlyphIds16))
+        {
+            auto ids = Alloc<uint16_t>(count, allocator);
+            outStreams->glyph_ids = *ids.ReinterpretCast<byte>();
+        }
+        else if (Flag::has(streams, ShapeStream::GlyphIds))
+        {
+            auto ids = Alloc<uint32_t>(count, allocator);
+            outStreams->glyph_ids = *ids.ReinterpretCast<byte>();
+        }
+        if (Flag::has(streams, ShapeStream::Clusters))
+            outStreams->clusters = Alloc<uint32_t>(count, allocator);
+        if (Flag::has(streams, ShapeStream::Advances))
+            outStreams->advances = Alloc<float2>(count, allocator);
+        if (Flag::has(streams, ShapeStream::Offsets))
+            outStreams->offsets = Alloc<float2>(count, allocator);
+
+        WriteShapeStreams(font_handle, glyphInfo, glyphPos, count, *outStreams);
+        hb_buffer_destroy(buffer);
+
+        return ReturnCode::Success;
+    }
+
+    /// @brief Shapes text into caller-owned streams, nothing is allocated through the alloc callback
+    /// @param font_handle
+    /// @param inText UTF-8 text
+    /// @param refStreams Destination, streams selects the streams to fill and count receives the number of shaped glyphs
+    /// @return ShapingOutTooSmall if a requested stream can't hold count glyphs, none are written in that case
+    ReturnCode ShapeTextStreamsInto(FontHandle *font_handle, Buffer<char> *inText, ShapedGlyphStreams *refStreams)
+    {
+        auto buffer = ShapeCached(font_handle, inText);
+
+        unsigned int glyphCount;
+        hb_glyph_info_t *glyphInfo = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+        hb_glyph_position_t *glyphPos = hb_buffer_get_glyph_positions(buffer, &glyphCount);
+        int count = static_cast<int>(glyphCount);
+        int streams = refStreams->streams;
+
+        refStreams->count = count;
+        int id_size = Flag::has(streams, ShapeStream::GlyphIds16) ? sizeof(uint16_t) : sizeof(uint32_t);
+        bool fits = (!Flag::has(streams, ShapeStream::GlyphIds | ShapeStream::GlyphIds16) || refStreams->glyph_ids.SizeInBytes() >= count * id_size) &&
+                    (!Flag::has(streams, ShapeStream::Clusters) || refStreams->clusters.Count() >= count) &&
+                    (!Flag::has(streams, ShapeStream::Advances) || refStreams->advances.Count() >= count) &&
+                    (!Flag::has(streams, ShapeStream::Offsets) || refStreams->offsets.Count() >= count);
+        if (!fits)
+            return ReturnCode::ShapingOutTooSmall;
+
+        WriteShapeStreams(font_handle, glyphInfo, glyphPos, count, *refStreams);
+        return ReturnCode::Success;
+    }
+
     Buffer<GlyphMetrics> CreateGlyphPixelMetricsBuffer(FontHandle *font_handle, Allocator allocator, Buffer<char> *inText)
     {
         auto shapingResult = ShapeText(font_handle, inText);
@@ -138,6 +270,129 @@ public:
         return result;
     }
 
+    /// @brief Shapes UTF-8 text with HarfBuzz, the caller destroys the returned buffer
+    /// @param font_handle
+    /// @param inText
+    /// @return
+    hb_buffer_t *ShapeBuffer(FontHandle *font_handle, Buffer<char> *inText)
+    {
+        auto buffer = hb_buffer_create();
+        hb_buffer_add_utf8(buffer, inText->Data(), inText->SizeInBytes(), 0, inText->SizeInBytes());
+        hb_buffer_set_direction(buffer, HB_DIRECTION_LTR);
+        hb_buffer_set_script(buffer, HB_SCRIPT_LATIN);
+        hb_buffer_set_language(buffer, hb_language_from_string("en", -1));
+        Shape(font_handle, buffer);
+        return buffer;
+    }
+
+    /// @brief Shapes UTF-8 text into a buffer owned by the calling thread. The result of the last call is kept,
+    /// so a size query followed by the actual fill with the same text only shapes once.
+    /// @param font_handle
+    /// @param inText
+    /// @return Buffer valid until the next call on the same thread
+    hb_buffer_t *ShapeCached(FontHandle *font_handle, Buffer<char> *inText)
+    {
+        struct ShapeScratch
+        {
+            hb_buffer_t *buffer = nullptr;
+            uint64_t font_id = 0;
+            std::string text;
+            ~ShapeScratch()
+            {
+                if (buffer != nullptr)
+                    hb_buffer_destroy(buffer);
+            }
+        };
+        thread_local ShapeScratch scratch;
+
+        const char *text = inText->Data();
+        size_t size = static_cast<size_t>(inText->SizeInBytes());
+        if (scratch.buffer == nullptr)
+            scratch.buffer = hb_buffer_create();
+        else if (scratch.font_id == font_handle->id && scratch.text.size() == size && std::memcmp(scratch.text.data(), text, size) == 0)
+            return scratch.buffer;
+
+        hb_buffer_clear_contents(scratch.buffer);
+        hb_buffer_add_utf8(scratch.buffer, text, inText->SizeInBytes(), 0, inText->SizeInBytes());
+        hb_buffer_set_direction(scratch.buffer, HB_DIRECTION_LTR);
+        hb_buffer_set_script(scratch.buffer, HB_SCRIPT_LATIN);
+        hb_buffer_set_language(scratch.buffer, hb_language_from_string("en", -1));
+        Shape(font_handle, scratch.buffer);
+        scratch.font_id = font_handle->id;
+        scratch.text.assign(text, size);
+        return scratch.buffer;
+    }
+
+    /// @brief Shapes a buffer of codepoints, text the font's simple shaping tables cover skips the HarfBuzz shaper
+    /// @param font_handle
+    /// @param buffer Buffer with direction, script and language set
+    static void Shape(FontHandle *font_handle, hb_buffer_t *buffer)
+    {
+        if (!font_handle->SimpleShape().Shape(buffer))
+            hb_shape(font_handle->hb, buffer, nullptr, 0);
+    }
+
+    static void WriteGlyphShapes(const hb_glyph_info_t *glyphInfo, const hb_glyph_position_t *glyphPos, unsigned int glyphCount, GlyphShape *out)
+    {
+        for (unsigned int i = 0; i < glyphCount; ++i)
+        {
+            auto ptr = &out[i];
+            ptr->codepoint = glyphInfo[i].codepoint;
+            ptr->cluster = glyphInfo[i].cluster;
+            ptr->offset_x_fu = glyphPos[i].x_offset;
+            ptr->offset_y_fu = glyphPos[i].y_offset;
+            ptr->advance_x_fu = glyphPos[i].x_advance;
+            ptr->advance_y_fu = glyphPos[i].y_advance;
+        }
+    }
+
+    /// @brief Fills the requested streams, which must hold at least count glyphs
+    static void WriteShapeStreams(FontHandle *font_handle, const hb_glyph_info_t *glyphInfo, const hb_glyph_position_t *glyphPos, int count, ShapedGlyphStreams &streams)
+    {
+        float to_em = 1.0f / static_cast<float>(hb_face_get_upem(hb_font_get_face(font_handle->hb)));
+
+        // One tight loop per stream, each reads a single field and writes contiguously so the compiler can vectorize it
+        if (Flag::has(streams.streams, ShapeStream::GlyphIds16))
+        {
+            uint16_t *out = reinterpret_cast<uint16_t *>(streams.glyph_ids.Data());
+            for (int i = 0; i < count; ++i)
+                out[i] = static_cast<uint16_t>(glyphInfo[i].codepoint);
+        }
+        else if (Flag::has(streams.streams, ShapeStream::GlyphIds))
+        {
+            uint32_t *out = reinterpret_cast<uint32_t *>(streams.glyph_ids.Data());
+            for (int i = 0; i < count; ++i)
+                out[i] = glyphInfo[i].codepoint;
+        }
+
+        if (Flag::has(streams.streams, ShapeStream::Clusters))
+        {
+            uint32_t *out = streams.clusters.Data();
+            for (int i = 0; i < count; ++i)
+                out[i] = glyphInfo[i].cluster;
+        }
+
+        if (Flag::has(streams.streams, ShapeStream::Advances))
+        {
+            float *out = reinterpret_cast<float *>(streams.advances.Data());
+            for (int i = 0; i < count; ++i)
+            {
+                out[2 * i] = glyphPos[i].x_advance * to_em;
+                out[2 * i + 1] = glyphPos[i].y_advance * to_em;
+            }
+        }
+
+        if (Flag::has(streams.streams, ShapeStream::Offsets))
+        {
+            float *out = reinterpret_cast<float *>(streams.offsets.Data());
+            for (int i = 0; i < count; ++i)
+            {
+                out[2 * i] = glyphPos[i].x_offset * to_em;
+                out[2 * i + 1] = glyphPos[i].y_offset * to_em;
+            }
+        }
+    }
+
     /// @brief Logs a message to the log callback
     /// @return 
     LogStream Log()
@@ -154,7 +409,7 @@ public:
     Buffer<T> Alloc(int length, Allocator allocator)
     {
         auto size = length * sizeof(T);
-        auto ptr = allocCallback(size, 4, allocator);
+        auto ptr = allocCallback(size, alignof(T), allocator);
         if (ptr == nullptr)
             throw std::bad_alloc();
         return Buffer<T>(ptr, size, allocator);
@@ -0,0 +1,215 @@
+#ifndef FACE_CACHE_H
+#define FACE_CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/// @brief Face cache state of a font. FreeType memory allocated while the font's face is locked is charged to it.
+struct FaceCacheEntry
+{
+    std::atomic<int64_t> bytes{0};
+    std::atomic<uint64_t> last_use{0};
+    std::atomic<bool> resident{false}; // Whether the face is open
+    std::mutex *mutex = nullptr;       // The font lock, eviction only happens while it's free
+    void *owner = nullptr;
+    void (*release)(void *owner) = nullptr; // Closes the face and drops what was loaded from it, called with the font lock held
+};
+
+/// @brief Bounds the FreeType memory of all fonts of a library. Every allocation of the library goes through the
+/// cache so it can be charged to the font whose face is locked on the calling thread. When the charged total exceeds
+/// the budget, the faces of the least recently used fonts are closed, their FontHandles reopen them on next use.
+class FaceCache
+{
+public:
+    static inline thread_local FaceCacheEntry *charged = nullptr; // Entry of the face locked on this thread
+
+    FaceCache()
+    {
+        memory.user = this;
+        memory.alloc = Alloc;
+        memory.free = Free;
+        memory.realloc = Realloc;
+    }
+
+    /// @brief Memory to create the FreeType library with, see FT_New_Library
+    /// @return
+    FT_Memory Memory()
+    {
+        return &memory;
+    }
+
+    /// @brief Sets the byte budget and evicts down to it right away
+    /// @param max_bytes 0 for no limit
+    void SetBudget(int64_t max_bytes)
+    {
+        budget = max_bytes;
+        Trim(nullptr);
+    }
+
+    /// @brief FreeType memory currently charged to the fonts
+    /// @return
+    int64_t Bytes() const
+    {
+        return bytes;
+    }
+
+    void Register(FaceCacheEntry *entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.push_back(entry);
+    }
+
+    /// @brief Removes a font from the cache, waits for an eviction of it that is in progress
+    /// @param entry
+    void Unregister(FaceCacheEntry *entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.erase(std::remove(entries.begin(), entries.end(), entry), entries.end());
+    }
+
+    /// @brief Marks a font as just used, called with its font lock held
+    /// @param entry
+    void Touch(FaceCacheEntry *entry)
+    {
+        entry->last_use = ++clock;
+        entry->resident = true;
+    }
+
+    /// @brief Closes the faces of the least recently used fonts until the charged total fits the budget. Fonts
+    /// locked by another thread are skipped.
+    /// @param keep Font that stays open, usually the one that was just used
+    void Trim(FaceCacheEntry *keep)
+    {
+        int64_t max_bytes = budget;
+        if (max_bytes <= 0 || bytes <= max_bytes)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<FaceCacheEntry *> coldest;
+        for (FaceCacheEntry *entry : entries)
+            if (entry != keep && entry->resident)
+                coldest.push_back(entry);
+        std::sort(coldest.begin(), coldest.end(), [](const FaceCacheEntry *a, const FaceCacheEntry *b)
+                  { return a->last_use < b->last_use; });
+
+        for (FaceCacheEntry *entry : coldest)
+        {
+            if (bytes <= max_bytes)
+                break;
+            std::unique_lock<std::mutex> font_lock(*entry->mutex, std::try_to_lock);
+            if (!font_lock.owns_lock())
+                continue;
+            entry->release(entry->owner);
+            entry->resident = false;
+        }
+    }
+
+private:
+    // Precedes every block, keeps the block aligned for any type
+    struct alignas(std::max_align_t) BlockHeader
+    {
+        FaceCacheEntry *entry;
+        long size;
+    };
+
+    FT_MemoryRec_ memory = {};
+    std::mutex mutex;
+    std::vector<FaceCacheEntry *> entries; // Guarded by the mutex
+    std::atomic<int64_t> bytes{0};
+    std::atomic<int64_t> budget{0};
+    std::atomic<uint64_t> clock{0};
+
+    void Charge(FaceCacheEntry *entry, long size)
+    {
+        if (entry == nullptr)
+            return;
+        entry->bytes += size;
+        bytes += size;
+    }
+
+    static void *Alloc(FT_Memory memory, long size)
+    {
+        auto header = static_cast<BlockHeader *>(std::malloc(sizeof(BlockHeader) + size));
+        if (header == nullptr)
+            return nullptr;
+        header->entry = charged;
+        header->size = size;
+        static_cast<FaceCache *>(memory->user)->Charge(header->entry, size);
+        return header + 1;
+    }
+
+    static void Free(FT_Memory memory, void *block)
+    {
+        if (block == nullptr)
+            return;
+        auto header = static_cast<BlockHeader *>(block) - 1;
+        static_cast<FaceCache *>(memory->user)->Charge(header->entry, -header->size);
+        std::free(header);
+    }
+
+    // The block stays charged to the font that allocated it
+    static void *Realloc(FT_Memory memory, long /*current_size*/, long new_size, void *block)
+    {
+        if (block == nullptr)
+            return Alloc(memory, new_size);
+        auto header = static_cast<BlockHeader *>(block) - 1;
+        FaceCacheEntry *entry = header->entry;
+        long old_size = header->size;
+        header = static_cast<BlockHeader *>(std::realloc(header, sizeof(BlockHeader) + new_size));
+        if (header == nullptr)
+            return nullptr;
+        header->size = new_size;
+        static_cast<FaceCache *>(memory->user)->Charge(entry, new_size - old_size);
+        return header + 1;
+    }
+};
+
+/// @brief Exclusive use of a font's FreeType face, FT_Face is not safe to share between threads. FreeType memory
+/// allocated while it's held is charged to the font, releasing it lets the cache evict colder fonts.
+class FaceLock
+{
+public:
+    FaceLock(std::mutex &mutex, FaceCache *cache, FaceCacheEntry *entry)
+        : lock(mutex), cache(cache), entry(entry), previous(FaceCache::charged)
+    {
+        FaceCache::charged = entry;
+        if (cache != nullptr)
+            cache->Touch(entry);
+    }
+
+    FaceLock(FaceLock &&other)
+        : lock(std::move(other.lock)), cache(other.cache), entry(other.entry), previous(other.previous)
+    {
+        other.cache = nullptr;
+        other.entry = nullptr;
+    }
+
+    FaceLock(const FaceLock &) = delete;
+    FaceLock &operator=(const FaceLock &) = delete;
+    FaceLock &operator=(FaceLock &&) = delete;
+
+    ~FaceLock()
+    {
+        if (entry == nullptr)
+            return;
+        FaceCache::charged = previous;
+        lock.unlock();
+        if (cache != nullptr)
+            cache->Trim(entry);
+    }
+
+private:
+    std::unique_lock<std::mutex> lock;
+    FaceCache *cache;
+    FaceCacheEntry *entry;
+    FaceCacheEntry *previous;
+};
+
+#endif
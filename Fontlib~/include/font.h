@@ -3,29 +3,342 @@
 
 #include "base.h"
 #include "buffer.h"
+#include "error.h"
+#include "mapped_file.h"
+#include "face_cache.h"
+#include "simple_shape.h"
+#include "outline_mesh.h"
 #include "hb.h"
 #include <log.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_GLYPH_H
+
+/// @brief Whether a glyph's contours overlap, decides if ResolveIntersections has to run the union on it
+enum class GlyphOverlap : uint8_t
+{
+    Unknown = 0,
+    Clean,
+    Overlapping
+};
+
+/// @brief Unscaled box and advances of a glyph, read from hmtx/vmtx and the glyf or CFF bounds
+struct GlyphTableMetrics
+{
+    int32_t left_fu;      // Horizontal bearing, x of the left edge of the box
+    int32_t top_fu;       // Vertical bearing, y of the top edge of the box
+    int32_t width_fu;
+    int32_t height_fu;
+    int32_t advance_x_fu;
+    int32_t advance_y_fu; // Negative downwards like HarfBuzz positions
+};
+
+/// @brief Finds a table in the sfnt directory of a font file, TrueType collections are resolved through their header
+/// @param data Whole font file
+/// @param size
+/// @param face_index Face of a collection, 0 for single fonts
+/// @param tag Table tag
+/// @param out_offset Offset of the table from the start of the file
+/// @param out_length
+/// @return False if the face or table doesn't exist or lies outside the file
+bool FindSfntTable(const byte *data, size_t size, int face_index, uint32_t tag, uint32_t &out_offset, uint32_t &out_length)
+{
+    if (size < 12)
+        return false;
+
+    size_t directory = 0;
+    if (ReadUInt32BE(data) == HB_TAG('t', 't', 'c', 'f'))
+    {
+        uint32_t face_count = ReadUInt32BE(data + 8);
+        if (face_index < 0 || static_cast<uint32_t>(face_index) >= face_count || 12 + 4 * size_t(face_index) + 4 > size)
+            return false;
+        directory = ReadUInt32BE(data + 12 + 4 * face_index);
+        if (directory + 12 > size)
+            return false;
+    }
+
+    uint16_t table_count = ReadUInt16BE(data + directory + 4);
+    size_t records = directory + 12;
+    if (records + 16 * size_t(table_count) > size)
+        return false;
+
+    for (uint16_t i = 0; i < table_count; i++)
+    {
+        const byte *record = data + records + 16 * i;
+        if (ReadUInt32BE(record) != tag)
+            continue;
+
+        out_offset = ReadUInt32BE(record + 8);
+        out_length = ReadUInt32BE(record + 12);
+        return size_t(out_offset) + out_length <= size;
+    }
+    return false;
+}
 
 class FontHandle
 {
 public:
-    FT_Face ft;
+    FT_Face ft; // Null while evicted from the face cache, Lock reopens it
     hb_font_t *hb;
+    std::mutex mutex;
+    int units_per_em = 0; // Set once at load and never written again, so it can be read without the lock
+    uint64_t id; // Unique for the lifetime of the process, unlike the handle address
+    std::vector<GlyphOverlap> overlap_cache; // Per glyph, filled lazily when rendering, guarded by the mutex
+    MappedFile file; // Backing memory of fonts loaded with OpenFile
+    FT_StreamRec stream; // Reads the face straight from the mapping, must outlive ft
+    int face_index = 0;
+    std::vector<GlyphTableMetrics> metrics_table; // Per glyph, built once by MetricsTable
+    std::once_flag metrics_once;
+    SimpleShapeTable simple_shape; // Built once by SimpleShape
+    std::once_flag simple_shape_once;
+    std::unordered_map<int32_t, std::vector<OutlineVertex>> outline_meshes; // Per glyph, filled lazily by LoadOutlineMesh, guarded by the mutex
+    FT_Glyph outline = nullptr; // Unscaled outline of outline_index, only the last one loaded is kept, guarded by the mutex
+    int32_t outline_index = -1;
+    FaceCache *face_cache = nullptr;
+    FaceCacheEntry cache_entry;
+
+    FontHandle() : ft(nullptr), hb(nullptr), id(NextId()) {}
 
-    FontHandle(FT_Library ftLib, Buffer<byte> fontData)
+    /// @brief Opens a font from memory that stays valid until the font is unloaded
+    /// @param ftLib
+    /// @param fontData
+    /// @param cache Face cache that may close the face when the font goes cold, null to keep it open
+    FontHandle(FT_Library ftLib, Buffer<byte> fontData, FaceCache *cache = nullptr) : ft(nullptr)
     {
-        FT_New_Memory_Face(ftLib, fontData.Data(), fontData.SizeInBytes(), 0, &ft);
+        id = NextId();
+        ft_library = ftLib;
+        face_data = fontData.Data();
+        face_size = fontData.SizeInBytes();
+        AttachFaceCache(cache);
+        {
+            auto lock = Lock();
+            if (ft != nullptr)
+                units_per_em = ft->units_per_EM;
+        }
         auto blob = hb_blob_create((const char *)fontData.Data(), fontData.SizeInBytes(), HB_MEMORY_MODE_READONLY, nullptr, nullptr);
         auto face = hb_face_create(blob, 0);
         hb = hb_font_create(face);
+        overlap_cache.assign(GlyphCount(), GlyphOverlap::Unknown);
+    }
+
+    /// @brief Opens a face of a font file through a memory mapping, FreeType and HarfBuzz read tables from the
+    /// mapping on demand so only the touched pages become resident
+    /// @param ftLib
+    /// @param path UTF-8 path of the font file
+    /// @param index Face index for TrueType collections, 0 for single fonts
+    /// @param cache Face cache that may close the face when the font goes cold, null to keep it open
+    /// @return FontNotFound if the file can't be mapped, Failure if it isn't a font or has no such face
+    ReturnCode OpenFile(FT_Library ftLib, const std::string &path, int index, FaceCache *cache = nullptr)
+    {
+        if (!file.Open(path))
+            return FontNotFound;
+
+        ft_library = ftLib;
+        face_index = index;
+        AttachFaceCache(cache);
+        {
+            auto lock = Lock();
+            units_per_em = ft != nullptr ? ft->units_per_EM : 0;
+        }
+        if (units_per_em == 0)
+        {
+            if (face_cache != nullptr)
+                face_cache->Unregister(&cache_entry);
+            file.Close();
+            return Failure;
+        }
+
+        auto face = hb_face_create_for_tables(ReferenceTable, this, nullptr);
+        hb_face_set_index(face, face_index);
+        hb = hb_font_create(face);
+        hb_face_destroy(face);
+        overlap_cache.assign(GlyphCount(), GlyphOverlap::Unknown);
+        return Success;
+    }
+
+    /// @brief Locks the FreeType face for exclusive use, FT_Face is not safe to share between threads. A face the
+    /// cache closed is reopened first.
+    /// @return
+    FaceLock Lock()
+    {
+        FaceLock lock(mutex, face_cache, &cache_entry);
+        if (ft == nullptr)
+            OpenFace();
+        return lock;
+    }
+
+    /// @brief Number of glyphs in the font, read from HarfBuzz so it doesn't need the FreeType face or the lock
+    /// @return
+    unsigned GlyphCount() const
+    {
+        return hb != nullptr ? hb_face_get_glyph_count(hb_font_get_face(hb)) : 0;
+    }
+
+    /// @brief Unscaled outline of a glyph. Only the last outline loaded is kept, so asking for the same glyph again,
+    /// e.g. after the overlap check, doesn't reload it while memory stays at one glyph per font. Needs the lock.
+    /// @param glyph_index
+    /// @return Null if the glyph has no outline, valid until the next call or until the face is closed
+    FT_Outline *Outline(int glyph_index)
+    {
+        if (glyph_index != outline_index)
+        {
+            DropOutline();
+            if (ft != nullptr && FT_Load_Glyph(ft, glyph_index, FT_LOAD_NO_SCALE) == 0 && FT_Get_Glyph(ft->glyph, &outline) != 0)
+                outline = nullptr;
+            outline_index = glyph_index;
+        }
+        if (outline == nullptr || outline->format != FT_GLYPH_FORMAT_OUTLINE)
+            return nullptr;
+        return &reinterpret_cast<FT_OutlineGlyph>(outline)->outline;
+    }
+
+    /// @brief Metrics of every glyph in the font, built on first use without loading any outline and without the
+    /// FreeType lock. Later calls are plain lookups.
+    /// @return Indexed by glyph index
+    const std::vector<GlyphTableMetrics> &MetricsTable()
+    {
+        std::call_once(metrics_once, [this]
+                       { BuildMetricsTable(); });
+        return metrics_table;
+    }
+
+    /// @brief Shaping tables for simple Latin-1 text, built on first use
+    /// @return
+    const SimpleShapeTable &SimpleShape()
+    {
+        std::call_once(simple_shape_once, [this]
+                       { simple_shape.Build(hb); });
+        return simple_shape;
     }
 
     void Dispose()
     {
-        FT_Done_Face(ft);
-        hb_font_destroy(hb);
+        if (face_cache != nullptr)
+            face_cache->Unregister(&cache_entry);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            CloseFace();
+        }
+        if (hb != nullptr)
+            hb_font_destroy(hb);
+        file.Close();
+    }
+
+private:
+    FT_Library ft_library = nullptr;
+    const byte *face_data = nullptr; // Font in memory, null for fonts opened with OpenFile
+    size_t face_size = 0;
+
+    void AttachFaceCache(FaceCache *cache)
+    {
+        face_cache = cache;
+        cache_entry.mutex = &mutex;
+        cache_entry.owner = this;
+        cache_entry.release = ReleaseFace;
+        if (face_cache != nullptr)
+            face_cache->Register(&cache_entry);
+    }
+
+    // Opens the face from the font memory or the file mapping, called with the lock held
+    void OpenFace()
+    {
+        if (face_data != nullptr)
+        {
+            if (FT_New_Memory_Face(ft_library, face_data, static_cast<FT_Long>(face_size), 0, &ft) != 0)
+                ft = nullptr;
+        }
+        else if (file.Data() != nullptr)
+        {
+            stream = {};
+            stream.base = const_cast<byte *>(file.Data());
+            stream.size = static_cast<unsigned long>(file.Size());
+
+            FT_Open_Args args = {};
+            args.flags = FT_OPEN_STREAM;
+            args.stream = &stream;
+            if (FT_Open_Face(ft_library, &args, face_index, &ft) != 0)
+                ft = nullptr;
+        }
+    }
+
+    // Closes the face and everything loaded from it, called with the lock held
+    void CloseFace()
+    {
+        DropOutline();
+        if (ft != nullptr)
+            FT_Done_Face(ft);
+        ft = nullptr;
+    }
+
+    void DropOutline()
+    {
+        if (outline != nullptr)
+            FT_Done_Glyph(outline);
+        outline = nullptr;
+        outline_index = -1;
+    }
+
+    static void ReleaseFace(void *owner)
+    {
+        static_cast<FontHandle *>(owner)->CloseFace();
+    }
+
+    void BuildMetricsTable()
+    {
+        unsigned count = GlyphCount();
+        metrics_table.assign(count, GlyphTableMetrics{});
+        if (count == 0)
+            return;
+
+        // The HarfBuzz font keeps its default scale of units per em, so everything comes back in font units
+        std::vector<hb_codepoint_t> indices(count);
+        for (unsigned i = 0; i < count; i++)
+            indices[i] = i;
+        std::vector<hb_position_t> advances(count);
+        hb_font_get_glyph_h_advances(hb, count, indices.data(), sizeof(hb_codepoint_t), advances.data(), sizeof(hb_position_t));
+        for (unsigned i = 0; i < count; i++)
+            metrics_table[i].advance_x_fu = advances[i];
+        hb_font_get_glyph_v_advances(hb, count, indices.data(), sizeof(hb_codepoint_t), advances.data(), sizeof(hb_position_t));
+        for (unsigned i = 0; i < count; i++)
+            metrics_table[i].advance_y_fu = advances[i];
+
+        // Boxes come from the glyf headers or the CFF charstring bounds, extents grow downwards
+        for (unsigned i = 0; i < count; i++)
+        {
+            hb_glyph_extents_t extents;
+            if (!hb_font_get_glyph_extents(hb, i, &extents))
+                continue;
+            auto &metrics = metrics_table[i];
+            metrics.left_fu = extents.x_bearing;
+            metrics.top_fu = extents.y_bearing;
+            metrics.width_fu = extents.width;
+            metrics.height_fu = -extents.height;
+        }
+    }
+
+    static uint64_t NextId()
+    {
+        static std::atomic<uint64_t> next_id(1);
+        return next_id++;
+    }
+
+    // Blobs alias the mapping, tag 0 asks for the whole file
+    static hb_blob_t *ReferenceTable(hb_face_t *face, hb_tag_t tag, void *user_data)
+    {
+        auto self = static_cast<FontHandle *>(user_data);
+        const char *data = reinterpret_cast<const char *>(self->file.Data());
+        if (tag == 0)
+            return hb_blob_create(data, static_cast<unsigned>(self->file.Size()), HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+
+        uint32_t offset, length;
+        if (!FindSfntTable(self->file.Data(), self->file.Size(), self->face_index, tag, offset, length))
+            return hb_blob_get_empty();
+        return hb_blob_create(data + offset, length, HB_MEMORY_MODE_READONLY, nullptr, nullptr);
     }
 };
 
@@ -42,9 +355,12 @@ public:
     int underline_pos;
     int underline_thickness;
 
-    FontDescription(FT_Library ftLib, Buffer<byte> fontData)
+    FontDescription(FT_Library ftLib, Buffer<byte> fontData) : FontDescription(new FontHandle(ftLib, fontData)) {}
+
+    FontDescription(FontHandle *handle)
     {
-        font_handle = new FontHandle(ftLib, fontData);
+        font_handle = handle;
+        auto lock = font_handle->Lock();
         FT_Face ftFace = font_handle->ft;
         units_per_em = ftFace->units_per_EM;
         ascender = ftFace->ascender;
@@ -1,7 +1,14 @@
 #ifndef GLYPH_H
 #define GLYPH_H
 
+#include <algorithm>
+#include <cmath>
 #include <stdint.h>
+#include "buffer.h"
+#include "mathematics.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
 
 /// @brief Glyph shape in font units
 struct GlyphShape
@@ -14,6 +21,28 @@ struct GlyphShape
     int32_t advance_y_fu;
 };
 
+/// @brief Streams that ShapeTextStreams can produce, callers only pay for the ones they request
+enum ShapeStream
+{
+    GlyphIds = 1 << 0,   // uint32_t glyph index per glyph
+    GlyphIds16 = 1 << 1, // uint16_t glyph index per glyph, takes precedence over GlyphIds
+    Clusters = 1 << 2,   // uint32_t cluster (byte offset into the UTF-8 text) per glyph
+    Advances = 1 << 3,   // float2 advance in em per glyph
+    Offsets = 1 << 4     // float2 offset in em per glyph
+};
+
+/// @brief Shaped glyphs as structure-of-arrays streams, positions already scaled to em.
+/// Streams that were not requested are empty buffers.
+struct ShapedGlyphStreams
+{
+    int32_t count;
+    int32_t streams;
+    Buffer<byte> glyph_ids;
+    Buffer<uint32_t> clusters;
+    Buffer<math::float2> advances;
+    Buffer<math::float2> offsets;
+};
+
 /// @brief Glyph metrics in font units
 struct GlyphMetrics
 {
@@ -26,12 +55,96 @@ struct GlyphMetrics
     int height_fu;
     int left_fu;
     int top_fu;
+    int atlas_page;
+    int glyph_size_px; // Pixels per em of the tile, differs from AtlasConfig::glyph_size with adaptive sizing
 
-    GlyphMetrics(int index) : index(index), atlas_x_px(0), atlas_y_px(0), width_fu(0), height_fu(0), left_fu(0), top_fu(0) {}
+    GlyphMetrics(int index = 0) : index(index), atlas_x_px(0), atlas_y_px(0), atlas_width_px(0), atlas_height_px(0), width_fu(0), height_fu(0), left_fu(0), top_fu(0), atlas_page(0), glyph_size_px(0) {}
 };
 
-void GetGlyphMetrics(Buffer<GlyphMetrics> glyphs, FontHandle *font_handle, int glyph_size, int padding)
+/// @brief Inclusive range of unicode codepoints
+struct UnicodeRange
 {
+    int32_t start;
+    int32_t end;
+};
+
+const float ADAPTIVE_MIN_FEATURE_PX = 1.5f;   // Texels the thinnest stroke of a glyph should span
+const float ADAPTIVE_REFERENCE_POINTS = 32.0f; // Outline points of a typical Latin glyph rendered at glyph_size
+
+/// @brief Picks the pixels per em of a glyph from its outline complexity. The stroke width is estimated as
+/// 2 * area / perimeter of the outline polygon, so thin strokes and busy outlines get more texels while
+/// blobs like '.' drop towards the minimum.
+/// @param outline Unscaled outline
+/// @param units_per_em
+/// @param glyph_size Size of a glyph of reference complexity
+/// @param min_glyph_size
+/// @param max_glyph_size
+/// @return
+int AdaptiveGlyphSize(const FT_Outline &outline, int units_per_em, int glyph_size, int min_glyph_size, int max_glyph_size)
+{
+    double area = 0.0;
+    double perimeter = 0.0;
+    for (int c = 0, start = 0; c < outline.n_contours; start = outline.contours[c] + 1, c++)
+    {
+        int end = outline.contours[c];
+        for (int i = start; i <= end; i++)
+        {
+            const FT_Vector &p = outline.points[i];
+            const FT_Vector &q = outline.points[i == end ? start : i + 1];
+            area += static_cast<double>(p.x) * q.y - static_cast<double>(q.x) * p.y;
+            perimeter += std::hypot(static_cast<double>(q.x - p.x), static_cast<double>(q.y - p.y));
+        }
+    }
+    if (perimeter <= 0.0)
+        return min_glyph_size;
+
+    // Holes wind the other way, so the sum is the inked area
+    double stroke_fu = std::abs(area) / perimeter;
+    double feature_size = stroke_fu > 0.0 ? ADAPTIVE_MIN_FEATURE_PX * units_per_em / stroke_fu : max_glyph_size;
+    double detail_size = glyph_size * std::sqrt(outline.n_points / ADAPTIVE_REFERENCE_POINTS);
+    double size = std::max(feature_size, detail_size);
+    return static_cast<int>(std::min<double>(max_glyph_size, std::max<double>(min_glyph_size, std::ceil(size))));
+}
+
+/// @brief Fills the glyph metrics for distance field glyphs. Without adaptive sizing the boxes come from the font's
+/// metrics table and no outline is loaded.
+/// @param glyphs Glyphs with their index set
+/// @param font_handle
+/// @param glyph_size Pixels per em
+/// @param padding Padding around each glyph in pixels
+/// @param min_glyph_size Lower bound of adaptive sizing, adaptive sizing is off unless both bounds are set
+/// @param max_glyph_size Upper bound of adaptive sizing
+void GetGlyphMetrics(Buffer<GlyphMetrics> glyphs, FontHandle *font_handle, int glyph_size, int padding, int min_glyph_size = 0, int max_glyph_size = 0)
+{
+    auto set_metrics = [&](GlyphMetrics &glyph, int width, int height, int left, int top, int size, int units_per_em)
+    {
+        glyph.width_fu = width;
+        glyph.height_fu = height;
+        glyph.left_fu = left;
+        glyph.top_fu = top;
+        glyph.glyph_size_px = size;
+        glyph.atlas_width_px = (width * size / units_per_em) + 2 * padding;
+        glyph.atlas_height_px = (height * size / units_per_em) + 2 * padding;
+    };
+
+    bool adaptive = min_glyph_size > 0 && max_glyph_size >= min_glyph_size;
+    if (!adaptive)
+    {
+        const auto &table = font_handle->MetricsTable();
+        int units_per_em = font_handle->units_per_em;
+        for (int i = 0; i < glyphs.Count(); ++i)
+        {
+            auto &glyph = glyphs[i];
+            GlyphTableMetrics metrics = {};
+            if (glyph.index >= 0 && glyph.index < static_cast<int>(table.size()))
+                metrics = table[glyph.index];
+            set_metrics(glyph, metrics.width_fu, metrics.height_fu, metrics.left_fu, metrics.top_fu, glyph_size, units_per_em);
+        }
+        return;
+    }
+
+    // Adaptive sizing measures the outline itself
+    auto lock = font_handle->Lock();
     FT_Face face = font_handle->ft;
     auto units_per_em = face->units_per_EM;
     for (int i = 0; i < glyphs.Count(); ++i)
@@ -39,12 +152,46 @@ void GetGlyphMetrics(Buffer<GlyphMetrics> glyphs, FontHandle *font_handle, int g
         auto &glyph = glyphs[i];
         FT_Load_Glyph(face, glyph.index, FT_LOAD_NO_SCALE);
         auto metrics = face->glyph->metrics;
-        glyph.width_fu = metrics.width;
-        glyph.height_fu = metrics.height;
-        glyph.left_fu = metrics.horiBearingX;
-        glyph.top_fu = metrics.horiBearingY;
-        glyph.atlas_width_px = (metrics.width * glyph_size / units_per_em) + 2 * padding;
-        glyph.atlas_height_px = (metrics.height * glyph_size / units_per_em) + 2 * padding;
+        int size = AdaptiveGlyphSize(face->glyph->outline, units_per_em, glyph_size, min_glyph_size, max_glyph_size);
+        set_metrics(glyph, metrics.width, metrics.height, metrics.horiBearingX, metrics.horiBearingY, size, units_per_em);
+    }
+}
+
+/// @brief Fills the glyph metrics for glyphs rasterized as hinted bitmaps at glyph_size pixels per em.
+/// The atlas size is the exact pixel box of the hinted bitmap, the font unit fields describe that same
+/// pixel box converted back to font units so layout places the quad on whole texels.
+void GetGlyphBitmapMetrics(Buffer<GlyphMetrics> glyphs, FontHandle *font_handle, int glyph_size, int padding)
+{
+    auto lock = font_handle->Lock();
+    FT_Face face = font_handle->ft;
+    auto units_per_em = face->units_per_EM;
+    FT_Set_Pixel_Sizes(face, 0, glyph_size);
+    auto to_font_units = [&](FT_Pos px)
+    { return static_cast<int>((px * units_per_em + glyph_size / 2) / glyph_size); };
+
+    for (int i = 0; i < glyphs.Count(); ++i)
+    {
+        auto &glyph = glyphs[i];
+        if (FT_Load_Glyph(face, glyph.index, FT_LOAD_TARGET_NORMAL) != 0)
+            continue;
+
+        // Same pixel rounding the smooth rasterizer applies to the control box
+        FT_BBox cbox;
+        FT_Outline_Get_CBox(&face->glyph->outline, &cbox);
+        FT_Pos left = cbox.xMin & -64;
+        FT_Pos bottom = cbox.yMin & -64;
+        FT_Pos right = (cbox.xMax + 63) & -64;
+        FT_Pos top = (cbox.yMax + 63) & -64;
+
+        FT_Pos width_px = (right - left) >> 6;
+        FT_Pos height_px = (top - bottom) >> 6;
+        glyph.width_fu = to_font_units(width_px);
+        glyph.height_fu = to_font_units(height_px);
+        glyph.left_fu = to_font_units(left >> 6);
+        glyph.top_fu = to_font_units(top >> 6);
+        glyph.glyph_size_px = glyph_size;
+        glyph.atlas_width_px = static_cast<int>(width_px) + 2 * padding;
+        glyph.atlas_height_px = static_cast<int>(height_px) + 2 * padding;
     }
 }
 
@@ -0,0 +1,328 @@
+#ifndef LINEAR_FIELD_H
+#define LINEAR_FIELD_H
+
+#include <float.h>
+#include <math.h>
+#include <vector>
+#include <msdfgen.h>
+#include "simd.h"
+
+// Pixels of a row evaluated together, the width of Float8
+constexpr int LINEAR_FIELD_LANES = 8;
+
+// Stands in for a missing perpendicular distance, never wins a comparison
+constexpr float LINEAR_FIELD_NO_DISTANCE = FLT_MAX;
+
+/// @brief Edges of a shape made only of line segments, as structure-of-arrays in single precision
+struct LinearEdges
+{
+    std::vector<float> ax, ay;           // Start point
+    std::vector<float> bx, by;           // End point
+    std::vector<float> abx, aby;         // Start to end
+    std::vector<float> dir_x, dir_y;     // Normalized direction, zero for degenerate edges
+    std::vector<float> inv_length_sq;    // 1 / |ab|^2, zero for degenerate edges
+    std::vector<float> start_x, start_y; // Bisector of the previous edge's and this edge's direction
+    std::vector<float> end_x, end_y;     // Bisector of this edge's and the next edge's direction
+    std::vector<int> color;              // msdfgen::EdgeColor bits
+
+    int Count() const { return static_cast<int>(ax.size()); }
+
+    /// @brief Copies the edges of a shape
+    /// @param shape
+    /// @return False if the shape has an edge that is not a msdfgen::LinearSegment
+    bool Load(const msdfgen::Shape &shape)
+    {
+        int count = 0;
+        for (const auto &contour : shape.contours)
+        {
+            for (const auto &edge : contour.edges)
+            {
+                if (dynamic_cast<const msdfgen::LinearSegment *>(static_cast<const msdfgen::EdgeSegment *>(edge)) == nullptr)
+                    return false;
+            }
+            count += static_cast<int>(contour.edges.size());
+        }
+
+        for (auto *v : {&ax, &ay, &bx, &by, &abx, &aby, &dir_x, &dir_y, &inv_length_sq, &start_x, &start_y, &end_x, &end_y})
+            v->resize(count);
+        color.resize(count);
+
+        int i = 0;
+        for (const auto &contour : shape.contours)
+        {
+            int first = i;
+            for (const auto &edge : contour.edges)
+            {
+                auto segment = static_cast<const msdfgen::LinearSegment *>(static_cast<const msdfgen::EdgeSegment *>(edge));
+                double x = segment->p[1].x - segment->p[0].x;
+                double y = segment->p[1].y - segment->p[0].y;
+                double length_sq = x * x + y * y;
+                double inv_length = length_sq > 0 ? 1.0 / sqrt(length_sq) : 0.0;
+
+                ax[i] = static_cast<float>(segment->p[0].x);
+                ay[i] = static_cast<float>(segment->p[0].y);
+                bx[i] = static_cast<float>(segment->p[1].x);
+                by[i] = static_cast<float>(segment->p[1].y);
+                abx[i] = static_cast<float>(x);
+                aby[i] = static_cast<float>(y);
+                dir_x[i] = static_cast<float>(x * inv_length);
+                dir_y[i] = static_cast<float>(y * inv_length);
+                inv_length_sq[i] = length_sq > 0 ? static_cast<float>(1.0 / length_sq) : 0.0f;
+                color[i] = segment->color;
+                i++;
+            }
+
+            // Corner bisectors decide which side of a corner an edge's extension covers, like msdfgen's selectors
+            int count_in_contour = i - first;
+            for (int k = 0; k < count_in_contour; k++)
+            {
+                int e = first + k;
+                int prev = first + (k + count_in_contour - 1) % count_in_contour;
+                int next = first + (k + 1) % count_in_contour;
+                Bisector(dir_x[prev], dir_y[prev], dir_x[e], dir_y[e], start_x[e], start_y[e]);
+                Bisector(dir_x[e], dir_y[e], dir_x[next], dir_y[next], end_x[e], end_y[e]);
+            }
+        }
+        return true;
+    }
+
+private:
+    static void Bisector(float x0, float y0, float x1, float y1, float &out_x, float &out_y)
+    {
+        float x = x0 + x1;
+        float y = y0 + y1;
+        float length = sqrtf(x * x + y * y);
+        out_x = length > 0 ? x / length : 0.0f;
+        out_y = length > 0 ? y / length : 0.0f;
+    }
+};
+
+/// @brief Closest edge of a channel for a batch of pixels, mirrors msdfgen's PerpendicularDistanceSelectorBase
+struct LinearChannelState
+{
+    Float8 distance;     // Signed true distance of the nearest edge
+    Float8 dot;          // Tie breaker between edges sharing the nearest point
+    Float8 param;        // Position of the nearest point along the nearest edge
+    Float8 edge;         // Index of the nearest edge, -1 if none, exact as float up to 2^24 edges
+    Float8 min_negative; // Closest non-positive perpendicular distance at a corner
+    Float8 min_positive; // Closest non-negative perpendicular distance at a corner
+
+    void Reset()
+    {
+        distance = -FLT_MAX;
+        dot = 0.0f;
+        param = 0.0f;
+        edge = -1.0f;
+        min_negative = -FLT_MAX;
+        min_positive = FLT_MAX;
+    }
+};
+
+/// @brief Distances of one edge to a batch of pixels
+struct LinearEdgeDistance
+{
+    Float8 distance;
+    Float8 dot;
+    Float8 param;
+    Float8 start_perpendicular; // Perpendicular distance past the start corner, or LINEAR_FIELD_NO_DISTANCE
+    Float8 end_perpendicular;   // Perpendicular distance past the end corner, or LINEAR_FIELD_NO_DISTANCE
+};
+
+/// @brief Distance from a batch of pixels on one row to an edge, LinearSegment::signedDistance in single precision
+/// plus the corner pseudo-distances msdfgen's MultiDistanceSelector adds
+inline void LinearEdgeDistances(const LinearEdges &edges, int e, Float8 px, Float8 py, LinearEdgeDistance &out)
+{
+    const Float8 zero = 0.0f;
+    const Float8 dir_x = edges.dir_x[e], dir_y = edges.dir_y[e];
+
+    Float8 aqx = px - edges.ax[e];
+    Float8 aqy = py - edges.ay[e];
+    Float8 bqx = px - edges.bx[e];
+    Float8 bqy = py - edges.by[e];
+    Float8 t = (aqx * edges.abx[e] + aqy * edges.aby[e]) * edges.inv_length_sq[e];
+
+    // Nearer endpoint, taken from the shared vertex so both edges of a corner tie exactly
+    Float8 far_end = t > 0.5f;
+    Float8 eqx = zero - Select(far_end, bqx, aqx);
+    Float8 eqy = zero - Select(far_end, bqy, aqy);
+    Float8 endpoint_distance = Sqrt(eqx * eqx + eqy * eqy);
+
+    Float8 cross = aqx * dir_y - aqy * dir_x;
+    Float8 interior = (t > zero) & (t < 1.0f) & (Abs(cross) < endpoint_distance);
+    Float8 endpoint_dot = Abs(dir_x * eqx + dir_y * eqy) / Max(endpoint_distance, FLT_MIN);
+    Float8 distance = Select(interior, cross, Select(cross > zero, endpoint_distance, zero - endpoint_distance));
+    Float8 abs_distance = Abs(distance);
+
+    out.distance = distance;
+    out.dot = Select(interior, zero, endpoint_dot);
+    out.param = t;
+
+    // Perpendicular distance to the extension before the start point, only on this edge's side of the corner
+    Float8 start_side = aqx * edges.start_x[e] + aqy * edges.start_y[e];
+    Float8 start_along = zero - (aqx * dir_x + aqy * dir_y);
+    Float8 start_valid = (start_side > zero) & (start_along > zero) & (Abs(cross) < abs_distance);
+    out.start_perpendicular = Select(start_valid, cross, LINEAR_FIELD_NO_DISTANCE);
+
+    // And after the end point
+    Float8 end_side = zero - (bqx * edges.end_x[e] + bqy * edges.end_y[e]);
+    Float8 end_along = bqx * dir_x + bqy * dir_y;
+    Float8 end_perpendicular = bqx * dir_y - bqy * dir_x;
+    Float8 end_valid = (end_side > zero) & (end_along > zero) & (Abs(end_perpendicular) < abs_distance);
+    out.end_perpendicular = Select(end_valid, end_perpendicular, LINEAR_FIELD_NO_DISTANCE);
+}
+
+/// @brief Merges an edge into a channel, branch-free across the lanes
+inline void LinearChannelAdd(LinearChannelState &state, const LinearEdgeDistance &edge_distance, Float8 e)
+{
+    const Float8 zero = 0.0f;
+    Float8 best = Abs(state.distance);
+    Float8 candidate = Abs(edge_distance.distance);
+    Float8 closer = (candidate < best) | ((candidate == best) & (edge_distance.dot < state.dot));
+    state.distance = Select(closer, edge_distance.distance, state.distance);
+    state.dot = Select(closer, edge_distance.dot, state.dot);
+    state.param = Select(closer, edge_distance.param, state.param);
+    state.edge = Select(closer, e, state.edge);
+
+    // Missing perpendicular distances are FLT_MAX and fail both tests
+    Float8 start = edge_distance.start_perpendicular;
+    Float8 end = edge_distance.end_perpendicular;
+    state.min_negative = Max(state.min_negative, Max(Select(start <= zero, start, -FLT_MAX), Select(end <= zero, end, -FLT_MAX)));
+    state.min_positive = Min(state.min_positive, Min(Select(start >= zero, start, FLT_MAX), Select(end >= zero, end, FLT_MAX)));
+}
+
+/// @brief Final distance of a channel at one pixel, msdfgen's PerpendicularDistanceSelectorBase::computeDistance
+/// @param distance Nearest true distance
+/// @param param Position along the nearest edge
+/// @param e Nearest edge, -1 if none
+/// @param min_negative
+/// @param min_positive
+/// @param px Pixel position in shape units
+/// @param py
+inline float LinearChannelDistance(const LinearEdges &edges, float distance, float param, int e, float min_negative, float min_positive, float px, float py)
+{
+    float min_distance = distance < 0.0f ? min_negative : min_positive;
+    if (e < 0)
+        return min_distance;
+
+    // Extend the nearest edge past its end points so corners stay sharp
+    if (param < 0.0f || param > 1.0f)
+    {
+        float qx = px - (param > 1.0f ? edges.bx[e] : edges.ax[e]);
+        float qy = py - (param > 1.0f ? edges.by[e] : edges.ay[e]);
+        float along = qx * edges.dir_x[e] + qy * edges.dir_y[e];
+        float perpendicular = qx * edges.dir_y[e] - qy * edges.dir_x[e];
+        if ((param < 0.0f ? along < 0.0f : along > 0.0f) && fabsf(perpendicular) <= fabsf(distance))
+            distance = perpendicular;
+    }
+    return fabsf(distance) < fabsf(min_distance) ? distance : min_distance;
+}
+
+/// @brief Generates a multi-channel distance field for a shape made only of line segments, such as the shapes of
+/// ResolveDecomposedShape. Matches msdfgen::generateMSDF / generateMTSDF without overlap support, in single precision,
+/// and applies the same error correction afterwards. The bitmap rows grow upwards like msdfgen's default.
+/// @tparam N 3 for MSDF, 4 for MTSDF with the true distance in alpha
+/// @param bitmap Output, width and height decide the area evaluated
+/// @param shape Edge-colored shape
+/// @param scale Pixels per shape unit
+/// @param translate Shape offset in shape units, the projection is (pixel / scale) - translate
+/// @param range Distance mapping range in shape units
+/// @param transform Same projection and range as msdfgen sees them, for the error correction
+/// @param config
+/// @return False if the shape has curves, the bitmap is untouched and msdfgen has to generate it
+template <int N>
+bool GenerateLinearField(msdfgen::Bitmap<float, N> &bitmap, const msdfgen::Shape &shape, float scale, msdfgen::Vector2 translate, float range,
+                         const msdfgen::SDFTransformation &transform, const msdfgen::MSDFGeneratorConfig &config)
+{
+    static_assert(N == 3 || N == 4, "GenerateLinearField writes MSDF or MTSDF");
+
+    LinearEdges edges;
+    if (!edges.Load(shape))
+        return false;
+
+    const int width = bitmap.width();
+    const int height = bitmap.height();
+    const float inv_scale = 1.0f / scale;
+    const float inv_range = 1.0f / range;
+    const float translate_x = static_cast<float>(translate.x);
+    const float translate_y = static_cast<float>(translate.y);
+
+    LinearChannelState channels[3];
+    LinearEdgeDistance edge_distance;
+    float lane_offsets[LINEAR_FIELD_LANES];
+    for (int l = 0; l < LINEAR_FIELD_LANES; l++)
+        lane_offsets[l] = static_cast<float>(l);
+    const Float8 lane_offset = Float8::Load(lane_offsets);
+
+    // Per-lane results of a batch, the sharp corner fix-up and the output are scalar
+    float px[LINEAR_FIELD_LANES], distance[4][LINEAR_FIELD_LANES], param[3][LINEAR_FIELD_LANES], edge[3][LINEAR_FIELD_LANES];
+    float min_negative[3][LINEAR_FIELD_LANES], min_positive[3][LINEAR_FIELD_LANES];
+
+    for (int y = 0; y < height; y++)
+    {
+        float py = (y + 0.5f) * inv_scale - translate_y;
+        for (int x0 = 0; x0 < width; x0 += LINEAR_FIELD_LANES)
+        {
+            Float8 batch_x = (lane_offset + (x0 + 0.5f)) * inv_scale - translate_x;
+            for (auto &channel : channels)
+                channel.Reset();
+
+            for (int e = 0; e < edges.Count(); e++)
+            {
+                LinearEdgeDistances(edges, e, batch_x, py, edge_distance);
+
+                // The edge color is uniform across the batch, only the lanes need to stay branch-free
+                int color = edges.color[e];
+                Float8 edge_index = static_cast<float>(e);
+                for (int c = 0; c < 3; c++)
+                {
+                    if (color & (1 << c))
+                        LinearChannelAdd(channels[c], edge_distance, edge_index);
+                }
+            }
+
+            // Every colored edge is in at least one channel, so the true distance is the nearest of the channels'
+            if (N == 4)
+            {
+                Float8 best = channels[0].distance;
+                Float8 best_dot = channels[0].dot;
+                for (int c = 1; c < 3; c++)
+                {
+                    Float8 candidate = Abs(channels[c].distance);
+                    Float8 current = Abs(best);
+                    Float8 closer = (candidate < current) | ((candidate == current) & (channels[c].dot < best_dot));
+                    best = Select(closer, channels[c].distance, best);
+                    best_dot = Select(closer, channels[c].dot, best_dot);
+                }
+                best.Store(distance[3]);
+            }
+
+            batch_x.Store(px);
+            for (int c = 0; c < 3; c++)
+            {
+                channels[c].distance.Store(distance[c]);
+                channels[c].param.Store(param[c]);
+                channels[c].edge.Store(edge[c]);
+                channels[c].min_negative.Store(min_negative[c]);
+                channels[c].min_positive.Store(min_positive[c]);
+            }
+
+            int lanes = width - x0 < LINEAR_FIELD_LANES ? width - x0 : LINEAR_FIELD_LANES;
+            for (int l = 0; l < lanes; l++)
+            {
+                float *pixel = bitmap(x0 + l, y);
+                for (int c = 0; c < 3; c++)
+                {
+                    float d = LinearChannelDistance(edges, distance[c][l], param[c][l], static_cast<int>(edge[c][l]), min_negative[c][l], min_positive[c][l], px[l], py);
+                    pixel[c] = d * inv_range + 0.5f;
+                }
+                if (N == 4)
+                    pixel[N - 1] = distance[3][l] * inv_range + 0.5f;
+            }
+        }
+    }
+
+    msdfgen::msdfErrorCorrection(bitmap, shape, transform, config);
+    return true;
+}
+
+#endif
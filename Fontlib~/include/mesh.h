@@ -0,0 +1,103 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <algorithm>
+#include <stdint.h>
+#include "buffer.h"
+#include "glyph.h"
+#include "atlas.h"
+#include "mathematics.h"
+
+/// @brief A laid-out glyph of a text block, the input of BuildTextMesh
+struct GlyphPlacement
+{
+    int32_t glyph_index;
+    math::float2 position_em; // Pen position from layout, y grows downwards
+    math::float2 offset_em;   // Shaping offset, y grows upwards
+    uint32_t color;           // RGBA8, r in the lowest byte
+};
+
+/// @brief Vertex of a text mesh, four per glyph in the order bottom-left, top-left, top-right, bottom-right
+struct GlyphVertex
+{
+    float x, y, z;
+    float u, v, page;
+    uint32_t color;
+};
+
+struct TextMeshConfig
+{
+    AtlasConfig atlas_config; // Atlas the glyph table was packed with
+    int32_t units_per_em;
+    float em_to_world; // Font size in world units
+};
+
+/// @brief Finds a glyph in a table sorted by glyph index
+/// @param table
+/// @param glyph_index
+/// @return Null if the glyph is not in the table
+inline const GlyphMetrics *FindGlyph(Buffer<GlyphMetrics> table, int32_t glyph_index)
+{
+    const GlyphMetrics *begin = table.Data();
+    const GlyphMetrics *end = begin + table.Count();
+    auto it = std::lower_bound(begin, end, glyph_index, [](const GlyphMetrics &glyph, int32_t index)
+                               { return glyph.index < index; });
+    return it != end && it->index == glyph_index ? it : nullptr;
+}
+
+/// @brief Writes the four vertices of every glyph in [first, first + count), other vertices are left untouched so a
+/// changed range of a text block can be rebuilt on its own. Glyphs missing from the table become degenerate quads.
+/// The placement math matches TextGlyphInitializationSystem and TextLayoutTransformUpdateSystem.
+/// @param config
+/// @param glyph_table Glyph metrics sorted by glyph index
+/// @param glyphs Placed glyphs of the text block
+/// @param first First glyph to write
+/// @param count Number of glyphs to write
+/// @param vertices Vertex buffer of the whole text block, 4 vertices per glyph
+void BuildTextMesh(const TextMeshConfig &config, Buffer<GlyphMetrics> glyph_table, Buffer<GlyphPlacement> glyphs, int first, int count, Buffer<GlyphVertex> vertices)
+{
+    float font_units_to_em = 1.0f / config.units_per_em;
+    float atlas_pixel_to_uv = 1.0f / config.atlas_config.size;
+    float scale = config.em_to_world;
+
+    for (int i = first; i < first + count; i++)
+    {
+        const GlyphPlacement &placement = glyphs[i];
+        GlyphVertex *quad = vertices.Data() + 4 * i;
+
+        const GlyphMetrics *glyph = FindGlyph(glyph_table, placement.glyph_index);
+        // Glyphs that didn't fit or were evicted have atlas_page = -1 and stale coordinates
+        if (glyph == nullptr || glyph->atlas_page < 0 || glyph->atlas_width_px <= 0 || glyph->atlas_height_px <= 0)
+        {
+            std::fill(quad, quad + 4, GlyphVertex{});
+            continue;
+        }
+
+        // Padding is in texels of the glyph's own tile size
+        float padding_em = 2.0f * config.atlas_config.padding / GlyphSizePx(*glyph, config.atlas_config);
+        float real_w = glyph->width_fu * font_units_to_em;
+        float real_h = glyph->height_fu * font_units_to_em;
+        float center_x = placement.position_em.x + placement.offset_em.x + glyph->left_fu * font_units_to_em + 0.5f * real_w;
+        float center_y = -placement.position_em.y + placement.offset_em.y + (glyph->top_fu - glyph->height_fu) * font_units_to_em + 0.5f * real_h;
+        float half_w = 0.5f * (real_w + padding_em);
+        float half_h = 0.5f * (real_h + padding_em);
+
+        float left = (center_x - half_w) * scale;
+        float right = (center_x + half_w) * scale;
+        float bottom = (center_y - half_h) * scale;
+        float top = (center_y + half_h) * scale;
+
+        float u0 = glyph->atlas_x_px * atlas_pixel_to_uv;
+        float v0 = glyph->atlas_y_px * atlas_pixel_to_uv;
+        float u1 = (glyph->atlas_x_px + glyph->atlas_width_px) * atlas_pixel_to_uv;
+        float v1 = (glyph->atlas_y_px + glyph->atlas_height_px) * atlas_pixel_to_uv;
+        float page = static_cast<float>(glyph->atlas_page);
+
+        quad[0] = {left, bottom, 0.0f, u0, v0, page, placement.color};
+        quad[1] = {left, top, 0.0f, u0, v1, page, placement.color};
+        quad[2] = {right, top, 0.0f, u1, v1, page, placement.color};
+        quad[3] = {right, bottom, 0.0f, u1, v0, page, placement.color};
+    }
+}
+
+#endif
@@ -0,0 +1,630 @@
+#ifndef OUTLINE_MESH_H
+#define OUTLINE_MESH_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+#include "shape.h"
+
+const int OUTLINE_CUBIC_MAX_DEPTH = 6;              // Subdivisions of a cubic before its quadratic approximation is accepted
+const double OUTLINE_CUBIC_TOLERANCE_EM = 1.0 / 4096; // Distance between a cubic and its quadratic approximation
+const int OUTLINE_OVERLAP_PASSES = 4;                // Subdivisions of curve triangles that overlap other curves or edges
+
+/// @brief Vertex of a glyph outline mesh, EM-normalized with y up from the glyph origin. Curve triangles carry
+/// Loop-Blinn coordinates, a fragment is inside the glyph where side * (u * u - v) <= 0. Interior triangles use
+/// u = 0, v = 1, side = 1 so the same test always passes.
+struct OutlineVertex
+{
+    float x, y;
+    float u, v;
+    float side; // 1 where the curve bulges out of the glyph, -1 where it bulges into it
+};
+
+/// @brief Triangles of one glyph in a batch of outline meshes
+struct OutlineMeshRange
+{
+    int32_t glyph_index;
+    int32_t first_vertex;
+    int32_t vertex_count; // 3 per triangle, 0 for glyphs without an outline
+};
+
+/// @brief Segment of a contour, a line or a quadratic Bezier curve
+struct QuadSegment
+{
+    PointD p0, c, p1; // c is unused for lines
+    bool curve;
+};
+
+/// @brief Outline of a glyph in font units with cubics approximated by quadratics, the input of the Loop-Blinn
+/// triangulation
+struct QuadOutline
+{
+    std::vector<std::vector<QuadSegment>> contours;
+    PointD current_pos = {0.0, 0.0};
+    double cubic_tolerance = 0.0; // In font units
+
+    void StartContour(PointD to)
+    {
+        contours.push_back({});
+        current_pos = to;
+    }
+
+    void AddLine(PointD to)
+    {
+        if (!contours.empty() && to != current_pos)
+            contours.back().push_back({current_pos, current_pos, to, false});
+        current_pos = to;
+    }
+
+    void AddConic(PointD ctrl, PointD to)
+    {
+        if (!contours.empty() && to != current_pos)
+            contours.back().push_back({current_pos, ctrl, to, true});
+        current_pos = to;
+    }
+
+    /// @brief Splits a cubic until a single quadratic approximates each piece within the tolerance
+    void AddCubic(PointD ctrl1, PointD ctrl2, PointD to, int depth = 0)
+    {
+        PointD from = current_pos;
+
+        // The approximation error of the quadratic through the midpoint of the control points is bounded by
+        // sqrt(3) / 36 * |p3 - 3 c2 + 3 c1 - p0|
+        double dx = to.x - 3 * ctrl2.x + 3 * ctrl1.x - from.x;
+        double dy = to.y - 3 * ctrl2.y + 3 * ctrl1.y - from.y;
+        if (depth >= OUTLINE_CUBIC_MAX_DEPTH || std::sqrt(3.0) / 36.0 * std::sqrt(dx * dx + dy * dy) <= cubic_tolerance)
+        {
+            PointD ctrl = {(3 * (ctrl1.x + ctrl2.x) - from.x - to.x) / 4, (3 * (ctrl1.y + ctrl2.y) - from.y - to.y) / 4};
+            AddConic(ctrl, to);
+            return;
+        }
+
+        // De Casteljau at t = 0.5
+        PointD a = Mid(from, ctrl1), b = Mid(ctrl1, ctrl2), c = Mid(ctrl2, to);
+        PointD ab = Mid(a, b), bc = Mid(b, c);
+        PointD middle = Mid(ab, bc);
+        AddCubic(a, ab, middle, depth + 1);
+        AddCubic(bc, c, to, depth + 1);
+    }
+
+    static PointD Mid(const PointD &a, const PointD &b)
+    {
+        return {0.5 * (a.x + b.x), 0.5 * (a.y + b.y)};
+    }
+
+    static int MoveTo(const FT_Vector *to, void *user)
+    {
+        static_cast<QuadOutline *>(user)->StartContour({static_cast<double>(to->x), static_cast<double>(to->y)});
+        return 0;
+    }
+
+    static int LineTo(const FT_Vector *to, void *user)
+    {
+        static_cast<QuadOutline *>(user)->AddLine({static_cast<double>(to->x), static_cast<double>(to->y)});
+        return 0;
+    }
+
+    static int ConicTo(const FT_Vector *control, const FT_Vector *to, void *user)
+    {
+        static_cast<QuadOutline *>(user)->AddConic({static_cast<double>(control->x), static_cast<double>(control->y)},
+                                                   {static_cast<double>(to->x), static_cast<double>(to->y)});
+        return 0;
+    }
+
+    static int CubicTo(const FT_Vector *control1, const FT_Vector *control2, const FT_Vector *to, void *user)
+    {
+        static_cast<QuadOutline *>(user)->AddCubic({static_cast<double>(control1->x), static_cast<double>(control1->y)},
+                                                   {static_cast<double>(control2->x), static_cast<double>(control2->y)},
+                                                   {static_cast<double>(to->x), static_cast<double>(to->y)});
+        return 0;
+    }
+};
+
+/**
+ * Decomposes an unscaled outline into lines and quadratic curves in font units.
+ *
+ * @param source The outline, e.g. from FontHandle::Outline. Null leaves the contours empty.
+ * @param units_per_em Units per EM of the font.
+ * @param outline Receives the contours.
+ */
+void DecomposeQuadOutline(FT_Outline *source, int units_per_em, QuadOutline &outline)
+{
+    if (source == nullptr)
+        return;
+    outline.cubic_tolerance = OUTLINE_CUBIC_TOLERANCE_EM * units_per_em;
+    FT_Outline_Funcs decompose_callbacks = {};
+    decompose_callbacks.move_to = QuadOutline::MoveTo;
+    decompose_callbacks.line_to = QuadOutline::LineTo;
+    decompose_callbacks.conic_to = QuadOutline::ConicTo;
+    decompose_callbacks.cubic_to = QuadOutline::CubicTo;
+    FT_Outline_Decompose(source, &decompose_callbacks, &outline);
+}
+
+/**
+ * Tells whether the interiors of two triangles overlap, touching edges and shared vertices don't count.
+ * Lines are passed as triangles with a repeated point.
+ */
+bool TrianglesOverlap(const PointD a[3], const PointD b[3])
+{
+    const PointD *triangles[2] = {a, b};
+    for (const PointD *triangle : triangles)
+    {
+        for (int e = 0; e < 3; e++)
+        {
+            // Separating axis perpendicular to each edge
+            const PointD &p = triangle[e];
+            const PointD &q = triangle[(e + 1) % 3];
+            double nx = q.y - p.y, ny = p.x - q.x;
+            double length = std::sqrt(nx * nx + ny * ny);
+            if (length == 0)
+                continue;
+            nx /= length;
+            ny /= length;
+
+            double a_min = INFINITY, a_max = -INFINITY, b_min = INFINITY, b_max = -INFINITY;
+            for (int i = 0; i < 3; i++)
+            {
+                double pa = a[i].x * nx + a[i].y * ny;
+                double pb = b[i].x * nx + b[i].y * ny;
+                a_min = std::min(a_min, pa);
+                a_max = std::max(a_max, pa);
+                b_min = std::min(b_min, pb);
+                b_max = std::max(b_max, pb);
+            }
+
+            const double epsilon = 1e-6; // Font units
+            if (a_max <= b_min + epsilon || b_max <= a_min + epsilon)
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Splits the curves whose triangles overlap another curve's triangle or a line, until every curve triangle only
+ * covers the area between its own curve and chord. Without this, the Loop-Blinn fill of one curve would leak into
+ * the neighbouring curve or the interior polygon.
+ */
+void SplitOverlappingCurves(QuadOutline &outline)
+{
+    for (int pass = 0; pass < OUTLINE_OVERLAP_PASSES; pass++)
+    {
+        struct Footprint
+        {
+            PointD points[3];
+            double l, b, r, t;
+            int contour, segment;
+        };
+
+        std::vector<Footprint> footprints;
+        for (size_t c = 0; c < outline.contours.size(); c++)
+        {
+            const auto &contour = outline.contours[c];
+            for (size_t s = 0; s < contour.size(); s++)
+            {
+                const QuadSegment &segment = contour[s];
+                Footprint footprint = {{segment.p0, segment.curve ? segment.c : segment.p1, segment.p1}, 0, 0, 0, 0, static_cast<int>(c), static_cast<int>(s)};
+                footprint.l = std::min({segment.p0.x, footprint.points[1].x, segment.p1.x});
+                footprint.r = std::max({segment.p0.x, footprint.points[1].x, segment.p1.x});
+                footprint.b = std::min({segment.p0.y, footprint.points[1].y, segment.p1.y});
+                footprint.t = std::max({segment.p0.y, footprint.points[1].y, segment.p1.y});
+                footprints.push_back(footprint);
+            }
+        }
+
+        std::vector<std::vector<char>> split(outline.contours.size());
+        for (size_t c = 0; c < outline.contours.size(); c++)
+            split[c].assign(outline.contours[c].size(), 0);
+
+        auto area = [&](const Footprint &footprint)
+        {
+            return std::fabs(Cross(footprint.points[0], footprint.points[1], footprint.points[2]));
+        };
+
+        bool any = false;
+        for (size_t i = 0; i < footprints.size(); i++)
+        {
+            const Footprint &f = footprints[i];
+            if (!outline.contours[f.contour][f.segment].curve)
+                continue;
+            for (size_t j = 0; j < footprints.size(); j++)
+            {
+                const Footprint &g = footprints[j];
+                if (i == j || g.r < f.l || f.r < g.l || g.t < f.b || f.t < g.b || !TrianglesOverlap(f.points, g.points))
+                    continue;
+
+                // Shrink the larger of two curve triangles, a line can only be avoided by shrinking the curve
+                bool g_curve = outline.contours[g.contour][g.segment].curve;
+                const Footprint &target = g_curve && area(g) > area(f) ? g : f;
+                split[target.contour][target.segment] = 1;
+                any = true;
+            }
+        }
+        if (!any)
+            return;
+
+        for (size_t c = 0; c < outline.contours.size(); c++)
+        {
+            std::vector<QuadSegment> contour;
+            for (size_t s = 0; s < outline.contours[c].size(); s++)
+            {
+                const QuadSegment &segment = outline.contours[c][s];
+                if (!split[c][s])
+                {
+                    contour.push_back(segment);
+                    continue;
+                }
+                PointD c0 = QuadOutline::Mid(segment.p0, segment.c);
+                PointD c1 = QuadOutline::Mid(segment.c, segment.p1);
+                PointD middle = QuadOutline::Mid(c0, c1);
+                contour.push_back({segment.p0, c0, middle, true});
+                contour.push_back({middle, c1, segment.p1, true});
+            }
+            outline.contours[c] = std::move(contour);
+        }
+    }
+}
+
+/**
+ * Signed area of a polygon, positive for counter-clockwise rings with y up.
+ */
+double RingArea(const std::vector<PointD> &ring)
+{
+    double area = 0;
+    for (size_t i = 0; i < ring.size(); i++)
+    {
+        const PointD &p = ring[i];
+        const PointD &q = ring[(i + 1) % ring.size()];
+        area += p.x * q.y - q.x * p.y;
+    }
+    return 0.5 * area;
+}
+
+bool PointInRing(const std::vector<PointD> &ring, const PointD &p)
+{
+    bool inside = false;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+    {
+        const PointD &a = ring[i];
+        const PointD &b = ring[j];
+        if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)
+            inside = !inside;
+    }
+    return inside;
+}
+
+/**
+ * Tells whether two segments cross at a point that isn't an endpoint of either.
+ */
+bool SegmentsCrossProperly(const PointD &a, const PointD &b, const PointD &c, const PointD &d)
+{
+    if (a == c || a == d || b == c || b == d)
+        return false;
+    SegmentD s = {a, b, 0, 0, 0, 0, 0, 0};
+    SegmentD t = {c, d, 0, 0, 0, 0, 0, 0};
+    return SegmentsIntersect(s, t);
+}
+
+/**
+ * Tells whether p lies in the interior wedge of ring vertex v, the interior being on the left.
+ */
+bool InWedge(const PointD &prev, const PointD &v, const PointD &next, const PointD &p)
+{
+    bool left_of_in = Cross(prev, v, p) > 0;
+    bool left_of_out = Cross(v, next, p) > 0;
+    return Cross(prev, v, next) >= 0 ? left_of_in && left_of_out : left_of_in || left_of_out;
+}
+
+/**
+ * Connects a hole to the counter-clockwise ring around it with a pair of bridge edges, giving a single ring that
+ * ear clipping can handle. The bridge goes from the rightmost hole vertex to the nearest ring vertex it can see.
+ *
+ * @param ring Outer ring, receives the hole
+ * @param hole Clockwise hole inside the ring
+ * @param obstacles Holes not merged yet, the bridge must not cross them
+ * @return False if no vertex is visible, the hole is then left out
+ */
+bool BridgeHole(std::vector<PointD> &ring, const std::vector<PointD> &hole, const std::vector<const std::vector<PointD> *> &obstacles)
+{
+    size_t m = 0;
+    for (size_t i = 1; i < hole.size(); i++)
+        if (hole[i].x > hole[m].x || (hole[i].x == hole[m].x && hole[i].y < hole[m].y))
+            m = i;
+    const PointD &from = hole[m];
+
+    std::vector<size_t> candidates(ring.size());
+    for (size_t i = 0; i < ring.size(); i++)
+        candidates[i] = i;
+    auto distance = [&](size_t i)
+    {
+        double dx = ring[i].x - from.x, dy = ring[i].y - from.y;
+        return dx * dx + dy * dy;
+    };
+    std::sort(candidates.begin(), candidates.end(), [&](size_t i, size_t j)
+              { return distance(i) < distance(j); });
+
+    auto crosses = [&](const std::vector<PointD> &path, const PointD &to)
+    {
+        for (size_t i = 0; i < path.size(); i++)
+            if (SegmentsCrossProperly(from, to, path[i], path[(i + 1) % path.size()]))
+                return true;
+        return false;
+    };
+
+    for (size_t v : candidates)
+    {
+        const PointD &to = ring[v];
+        if (to == from || !InWedge(ring[(v + ring.size() - 1) % ring.size()], to, ring[(v + 1) % ring.size()], from))
+            continue;
+        if (crosses(ring, to) || crosses(hole, to))
+            continue;
+        bool blocked = false;
+        for (const auto *obstacle : obstacles)
+            blocked = blocked || crosses(*obstacle, to);
+        if (blocked)
+            continue;
+
+        std::vector<PointD> merged;
+        merged.reserve(ring.size() + hole.size() + 2);
+        merged.insert(merged.end(), ring.begin(), ring.begin() + v + 1);
+        for (size_t i = 0; i <= hole.size(); i++)
+            merged.push_back(hole[(m + i) % hole.size()]);
+        merged.insert(merged.end(), ring.begin() + v, ring.end());
+        ring = std::move(merged);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Triangulates a counter-clockwise ring by ear clipping. Collinear vertices are dropped without a triangle, a ring
+ * that has no ear left, e.g. after a bad bridge, has its remaining convex vertices clipped regardless.
+ */
+void ClipEars(const std::vector<PointD> &ring, std::vector<PointD> &out_triangles)
+{
+    int n = static_cast<int>(ring.size());
+    if (n < 3)
+        return;
+    std::vector<int> prev(n), next(n);
+    for (int i = 0; i < n; i++)
+    {
+        prev[i] = (i + n - 1) % n;
+        next[i] = (i + 1) % n;
+    }
+
+    auto is_ear = [&](int i)
+    {
+        const PointD &a = ring[prev[i]], &b = ring[i], &c = ring[next[i]];
+        for (int j = next[next[i]]; j != prev[i]; j = next[j])
+        {
+            const PointD &p = ring[j];
+            if (p == a || p == b || p == c)
+                continue;
+            if (Cross(a, b, p) >= 0 && Cross(b, c, p) >= 0 && Cross(c, a, p) >= 0)
+                return false;
+        }
+        return true;
+    };
+
+    int remaining = n;
+    int i = 0;
+    int stalled = 0;
+    bool force = false;
+    while (remaining > 2)
+    {
+        const PointD &a = ring[prev[i]], &b = ring[i], &c = ring[next[i]];
+        double turn = Cross(a, b, c);
+        double scale = std::fabs(b.x - a.x) + std::fabs(b.y - a.y) + std::fabs(c.x - b.x) + std::fabs(c.y - b.y);
+        bool degenerate = std::fabs(turn) <= 1e-12 * scale * scale;
+        bool clip = degenerate || (turn > 0 && (force || is_ear(i)));
+        if (!clip)
+        {
+            i = next[i];
+            if (++stalled > remaining)
+            {
+                if (force)
+                    return; // Nothing convex is left
+                force = true;
+                stalled = 0;
+            }
+            continue;
+        }
+
+        if (!degenerate)
+        {
+            out_triangles.push_back(a);
+            out_triangles.push_back(b);
+            out_triangles.push_back(c);
+        }
+        next[prev[i]] = next[i];
+        prev[next[i]] = prev[i];
+        remaining--;
+        i = prev[i];
+        stalled = 0;
+        force = false;
+    }
+}
+
+/**
+ * Triangulates the area covered by rings under the non-zero rule, counter-clockwise rings are outer boundaries and
+ * clockwise rings are holes. Rings must not cross each other.
+ */
+void TriangulateRings(std::vector<std::vector<PointD>> rings, std::vector<PointD> &out_triangles)
+{
+    std::vector<double> areas(rings.size());
+    std::vector<size_t> outers, holes;
+    for (size_t i = 0; i < rings.size(); i++)
+    {
+        areas[i] = rings[i].size() >= 3 ? RingArea(rings[i]) : 0;
+        if (areas[i] > 0)
+            outers.push_back(i);
+        else if (areas[i] < 0)
+            holes.push_back(i);
+    }
+
+    // Each hole belongs to the smallest outer ring around it
+    std::vector<std::vector<size_t>> outer_holes(rings.size());
+    for (size_t hole : holes)
+    {
+        size_t owner = rings.size();
+        for (size_t outer : outers)
+            if ((owner == rings.size() || areas[outer] < areas[owner]) && PointInRing(rings[outer], rings[hole][0]))
+                owner = outer;
+        if (owner != rings.size())
+            outer_holes[owner].push_back(hole);
+    }
+
+    for (size_t outer : outers)
+    {
+        auto &own = outer_holes[outer];
+        auto max_x = [&](size_t ring)
+        {
+            double x = -INFINITY;
+            for (const PointD &p : rings[ring])
+                x = std::max(x, p.x);
+            return x;
+        };
+        std::sort(own.begin(), own.end(), [&](size_t a, size_t b)
+                  { return max_x(a) > max_x(b); });
+
+        std::vector<PointD> ring = rings[outer];
+        for (size_t h = 0; h < own.size(); h++)
+        {
+            std::vector<const std::vector<PointD> *> obstacles;
+            for (size_t k = h + 1; k < own.size(); k++)
+                obstacles.push_back(&rings[own[k]]);
+            BridgeHole(ring, rings[own[h]], obstacles);
+        }
+        ClipEars(ring, out_triangles);
+    }
+}
+
+/**
+ * Builds the Loop-Blinn mesh of a glyph whose contours don't overlap: an ear-clipped interior polygon through the
+ * on-curve points, and through the control points of curves that bulge inwards, plus one triangle per curve.
+ *
+ * @param outline Quadratic outline from DecomposeQuadOutline, curves may get split
+ * @param units_per_em Units per EM of the font.
+ * @param out_vertices Receives the triangles, EM-normalized
+ */
+void TriangulateQuadOutline(QuadOutline &outline, int units_per_em, std::vector<OutlineVertex> &out_vertices)
+{
+    // Curves that are almost straight are plain edges
+    for (auto &contour : outline.contours)
+        for (auto &segment : contour)
+            if (segment.curve && std::fabs(Cross(segment.p0, segment.c, segment.p1)) <= 1e-9 * units_per_em * units_per_em)
+                segment.curve = false;
+
+    // Fonts wind their outer contours either way, turn them counter-clockwise so the interior is on the left of
+    // every contour. The largest contour is always an outer one.
+    auto contour_area = [](const std::vector<QuadSegment> &contour)
+    {
+        double area = 0;
+        for (const QuadSegment &segment : contour)
+        {
+            area += 0.5 * (segment.p0.x * segment.p1.y - segment.p1.x * segment.p0.y);
+            if (segment.curve)
+                area += 2.0 / 3.0 * 0.5 * Cross(segment.p0, segment.c, segment.p1);
+        }
+        return area;
+    };
+    double largest = 0;
+    for (const auto &contour : outline.contours)
+    {
+        double area = contour_area(contour);
+        if (std::fabs(area) > std::fabs(largest))
+            largest = area;
+    }
+    if (largest < 0)
+    {
+        for (auto &contour : outline.contours)
+        {
+            std::reverse(contour.begin(), contour.end());
+            for (auto &segment : contour)
+                std::swap(segment.p0, segment.p1);
+        }
+    }
+
+    SplitOverlappingCurves(outline);
+
+    float scale = 1.0f / units_per_em;
+    auto vertex = [&](const PointD &p, float u, float v, float side)
+    {
+        return OutlineVertex{static_cast<float>(p.x) * scale, static_cast<float>(p.y) * scale, u, v, side};
+    };
+
+    std::vector<std::vector<PointD>> rings;
+    for (const auto &contour : outline.contours)
+    {
+        std::vector<PointD> ring;
+        for (const QuadSegment &segment : contour)
+        {
+            ring.push_back(segment.p0);
+            if (!segment.curve)
+                continue;
+
+            // The control point lies inside the glyph for curves that bulge inwards, the polygon then goes around it
+            // and the curve triangle fills the part beyond the curve
+            bool inwards = Cross(segment.p0, segment.p1, segment.c) > 0;
+            float side = inwards ? -1.0f : 1.0f;
+            if (inwards)
+                ring.push_back(segment.c);
+            out_vertices.push_back(vertex(segment.p0, 0.0f, 0.0f, side));
+            out_vertices.push_back(vertex(segment.c, 0.5f, 0.0f, side));
+            out_vertices.push_back(vertex(segment.p1, 1.0f, 1.0f, side));
+        }
+        rings.push_back(std::move(ring));
+    }
+
+    std::vector<PointD> triangles;
+    TriangulateRings(std::move(rings), triangles);
+    for (const PointD &p : triangles)
+        out_vertices.push_back(vertex(p, 0.0f, 1.0f, 1.0f));
+}
+
+/**
+ * Builds the mesh of a glyph with overlapping contours from the Clipper union of its flattened contours. The union
+ * has no curves left, so the mesh is made of interior triangles only.
+ *
+ * @param decompose_data The flattened contours from DecomposeGlyph.
+ * @param units_per_em Units per EM of the font.
+ * @param out_vertices Receives the triangles, EM-normalized
+ */
+void TriangulateResolvedOutline(const DecomposeData &decompose_data, int units_per_em, std::vector<OutlineVertex> &out_vertices)
+{
+    Clipper2Lib::Paths64 clipper_paths;
+    for (const auto &contour : decompose_data.contours)
+    {
+        Clipper2Lib::Path64 path;
+        for (const auto &point : contour)
+            path.push_back(Clipper2Lib::Point64(
+                static_cast<int64_t>(std::round(point.x * CLIPPER_SCALE_FACTOR)),
+                static_cast<int64_t>(std::round(point.y * CLIPPER_SCALE_FACTOR))));
+        if (path.size() >= 3)
+            clipper_paths.push_back(std::move(path));
+    }
+
+    Clipper2Lib::Clipper64 clipper;
+    Clipper2Lib::Paths64 solution_paths;
+    clipper.AddSubject(std::move(clipper_paths));
+    clipper.Execute(Clipper2Lib::ClipType::Union, Clipper2Lib::FillRule::NonZero, solution_paths);
+
+    // The union winds outer paths counter-clockwise and holes clockwise
+    std::vector<std::vector<PointD>> rings;
+    for (const auto &path : solution_paths)
+    {
+        std::vector<PointD> ring;
+        for (const auto &point : path)
+            ring.push_back({point.x / CLIPPER_SCALE_FACTOR, point.y / CLIPPER_SCALE_FACTOR});
+        rings.push_back(std::move(ring));
+    }
+
+    std::vector<PointD> triangles;
+    TriangulateRings(std::move(rings), triangles);
+    float scale = 1.0f / units_per_em;
+    for (const PointD &p : triangles)
+        out_vertices.push_back({static_cast<float>(p.x) * scale, static_cast<float>(p.y) * scale, 0.0f, 1.0f, 1.0f});
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// @brief Returns the number of worker threads to use when none is specified
+/// @return
+inline int DefaultThreadCount()
+{
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+/// @brief Runs fn(i) for every i in [0, count) on a pool of threads, blocks until all calls have returned
+/// @tparam F Callable taking an int index
+/// @param count Number of work items
+/// @param fn Work item function, must be safe to call concurrently
+/// @param thread_count Number of threads, 0 uses all hardware threads
+template <typename F>
+void ParallelFor(int count, F &&fn, int thread_count = 0)
+{
+    if (thread_count <= 0)
+        thread_count = DefaultThreadCount();
+    thread_count = std::min(thread_count, count);
+
+    if (thread_count <= 1)
+    {
+        for (int i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    // Items are handed out one at a time since their cost varies a lot (e.g. '.' vs a CJK glyph)
+    std::atomic<int> next(0);
+    auto worker = [&]()
+    {
+        for (int i = next++; i < count; i = next++)
+            fn(i);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (int t = 0; t < thread_count - 1; t++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+#endif
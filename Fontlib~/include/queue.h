@@ -0,0 +1,197 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "font.h"
+#include "atlas.h"
+#include "render.h"
+#include "parallel.h"
+
+/// @brief A glyph waiting to be rendered by the render queue
+struct GlyphRenderRequest
+{
+    FontHandle *font_handle;
+    GlyphMetrics glyph;
+    AtlasConfig atlas_config;
+    RenderConfig render_config;
+    Buffer<byte> texture;
+    int priority;
+    uint64_t sequence;
+};
+
+/// @brief Asynchronous glyph render queue, background workers render the highest priority requests first.
+/// Requests of the same priority are rendered in submission order.
+class GlyphRenderQueue
+{
+public:
+    GlyphRenderQueue() = default;
+    GlyphRenderQueue(const GlyphRenderQueue &) = delete;
+    GlyphRenderQueue &operator=(const GlyphRenderQueue &) = delete;
+
+    ~GlyphRenderQueue()
+    {
+        Shutdown();
+    }
+
+    /// @brief Stops the workers after their current glyph, queued glyphs are dropped
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            pending.clear();
+        }
+        work_cv.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+        workers.clear();
+    }
+
+    /// @brief Queues glyphs for rendering, the workers are started on first use
+    /// @param font_handle
+    /// @param atlas_config
+    /// @param render_config
+    /// @param priority Higher priorities are rendered first, e.g. on-screen text over prewarming
+    /// @param glyphs Packed glyphs
+    /// @param texture Atlas page the glyphs are packed into, must stay alive until the glyphs complete or the font is cancelled
+    void Enqueue(FontHandle *font_handle, AtlasConfig atlas_config, RenderConfig render_config, int priority, Buffer<GlyphMetrics> glyphs, Buffer<byte> texture)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+                return;
+            for (int i = 0; i < glyphs.Count(); i++)
+            {
+                pending.push_back({font_handle, glyphs[i], atlas_config, render_config, texture, priority, next_sequence++});
+                std::push_heap(pending.begin(), pending.end(), Compare);
+            }
+            StartWorkers();
+        }
+        work_cv.notify_all();
+    }
+
+    /// @brief Moves the glyphs of a font that finished rendering since the last poll into out
+    /// @param font_handle
+    /// @param max_count Maximum number of glyphs to return, 0 for all
+    /// @param out
+    void Poll(FontHandle *font_handle, int max_count, std::vector<GlyphMetrics> &out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = completed.find(font_handle);
+        if (it == completed.end())
+            return;
+
+        auto &glyphs = it->second;
+        size_t count = max_count > 0 ? std::min(glyphs.size(), static_cast<size_t>(max_count)) : glyphs.size();
+        out.insert(out.end(), glyphs.begin(), glyphs.begin() + count);
+        glyphs.erase(glyphs.begin(), glyphs.begin() + count);
+        if (glyphs.empty())
+            completed.erase(it);
+    }
+
+    /// @brief Number of glyphs of a font that are queued or being rendered
+    /// @param font_handle
+    /// @return
+    int PendingCount(FontHandle *font_handle)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        int count = static_cast<int>(std::count(in_flight.begin(), in_flight.end(), font_handle));
+        for (auto &request : pending)
+        {
+            if (request.font_handle == font_handle)
+                count++;
+        }
+        return count;
+    }
+
+    /// @brief Drops all queued and completed glyphs of a font and waits for the ones being rendered
+    /// @param font_handle
+    void Cancel(FontHandle *font_handle)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        pending.erase(
+            std::remove_if(pending.begin(), pending.end(), [font_handle](const GlyphRenderRequest &request)
+                           { return request.font_handle == font_handle; }),
+            pending.end());
+        std::make_heap(pending.begin(), pending.end(), Compare);
+
+        idle_cv.wait(lock, [&]()
+                     { return std::find(in_flight.begin(), in_flight.end(), font_handle) == in_flight.end(); });
+        completed.erase(font_handle);
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable idle_cv;
+    std::vector<std::thread> workers;
+    std::vector<GlyphRenderRequest> pending; // Binary heap ordered by Compare
+    std::vector<FontHandle *> in_flight;
+    std::unordered_map<FontHandle *, std::vector<GlyphMetrics>> completed;
+    uint64_t next_sequence = 0;
+    bool stopping = false;
+
+    // Heap order, the top is the highest priority and oldest request
+    static bool Compare(const GlyphRenderRequest &a, const GlyphRenderRequest &b)
+    {
+        if (a.priority != b.priority)
+            return a.priority < b.priority;
+        return a.sequence > b.sequence;
+    }
+
+    void StartWorkers()
+    {
+        if (!workers.empty())
+            return;
+
+        // Leave a core for the thread that submits and polls
+        int count = std::max(1, DefaultThreadCount() - 1);
+        workers.reserve(count);
+        for (int i = 0; i < count; i++)
+            workers.emplace_back(&GlyphRenderQueue::WorkerLoop, this);
+    }
+
+    void WorkerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            work_cv.wait(lock, [&]()
+                         { return stopping || !pending.empty(); });
+            if (stopping)
+                return;
+
+            std::pop_heap(pending.begin(), pending.end(), Compare);
+            auto request = pending.back();
+            pending.pop_back();
+            in_flight.push_back(request.font_handle);
+
+            lock.unlock();
+            bool rendered = true;
+            try
+            {
+                // Unpacked glyphs keep stale coordinates that may overlap live tiles, empty ones have nothing to draw
+                const GlyphMetrics &glyph = request.glyph;
+                if (glyph.atlas_page >= 0 && glyph.atlas_width_px > 0 && glyph.atlas_height_px > 0)
+                    RenderGlyphToAtlas(request.font_handle, request.glyph, request.atlas_config, request.render_config, &request.texture);
+            }
+            catch (...)
+            {
+                rendered = false;
+            }
+            lock.lock();
+
+            in_flight.erase(std::find(in_flight.begin(), in_flight.end(), request.font_handle));
+            if (rendered)
+                completed[request.font_handle].push_back(request.glyph);
+            idle_cv.notify_all();
+        }
+    }
+};
+
+#endif
@@ -10,77 +10,386 @@
 #include <mathematics.h>
 #include <math.h>
 #include <glyph.h>
+#include <linear_field.h>
 
 using namespace math;
 
 enum GlyphRenderFlag
 {
-    ResolveIntersections = 1 << 0
+    ResolveIntersections = 1 << 0,
+    RasterizeBitmap = 1 << 2 // Hinted 8-bit coverage from FreeType instead of MTSDF, for small pixel sizes
+};
+
+/// @brief Kind of distance field stored in the atlas, decides the number of channels
+enum GlyphFieldType
+{
+    MTSDF = 0, // Multi-channel + true distance in alpha, 4 channels
+    MSDF = 1,  // Multi-channel, sharp corners, 3 channels
+    PSDF = 2,  // Single-channel perpendicular distance, 1 channel
+    SDF = 3    // Single-channel true distance, rounded corners, 1 channel
+};
+
+/// @brief MSDF error correction mode, ignored by the single-channel field types
+enum GlyphErrorCorrection
+{
+    EdgePriority = 0,   // msdfgen default, corrects artifacts while protecting edges and corners
+    Disabled = 1,       // No correction, fastest
+    EdgeOnly = 2,       // Only corrects artifacts near edges
+    Indiscriminate = 3, // Corrects all detected artifacts
 };
 
 struct RenderConfig
 {
     float distance_mapping_range = 0.5f; // Distance mapping range for MSDF generation
     int flags = 0;                       // Render flags (e.g., resolve intersections)
+    int field_type = 0;                  // GlyphFieldType
+    int error_correction = 0;            // GlyphErrorCorrection
+};
+
+template <int N>
+struct Pixel
+{
+    uint8_t channels[N];
+};
+
+/// @brief Compile-time description of a distance field type
+template <GlyphFieldType Type>
+struct FieldTraits;
+
+template <>
+struct FieldTraits<GlyphFieldType::MTSDF>
+{
+    static constexpr int Channels = 4;
+    static constexpr bool Colored = true;
+    static void Generate(msdfgen::Bitmap<float, 4> &bitmap, const msdfgen::Shape &shape, const msdfgen::SDFTransformation &transform, const msdfgen::MSDFGeneratorConfig &config)
+    {
+        msdfgen::generateMTSDF(bitmap, shape, transform, config);
+    }
+    static bool GenerateLinear(msdfgen::Bitmap<float, 4> &bitmap, const msdfgen::Shape &shape, float scale, msdfgen::Vector2 translate, float range, const msdfgen::SDFTransformation &transform, const msdfgen::MSDFGeneratorConfig &config)
+    {
+        return GenerateLinearField<4>(bitmap, shape, scale, translate, range, transform, config);
+    }
+};
+
+template <>
+struct FieldTraits<GlyphFieldType::MSDF>
+{
+    static constexpr int Channels = 3;
+    static constexpr bool Colored = true;
+    static void Generate(msdfgen::Bitmap<float, 3> &bitmap, const msdfgen::Shape &shape, const msdfgen::SDFTransformation &transform, const msdfgen::MSDFGeneratorConfig &config)
+    {
+        msdfgen::generateMSDF(bitmap, shape, transform, config);
+    }
+    static bool GenerateLinear(msdfgen::Bitmap<float, 3> &bitmap, const msdfgen::Shape &shape, float scale, msdfgen::Vector2 translate, float range, const msdfgen::SDFTransformation &transform, const msdfgen::MSDFGeneratorConfig &config)
+    {
+        return GenerateLinearField<3>(bitmap, shape, scale, translate, range, transform, config);
+    }
 };
 
-struct RGBA32Pixel
+template <>
+struct FieldTraits<GlyphFieldType::PSDF>
 {
-    uint8_t r, g, b, a;
+    static constexpr int Channels = 1;
+    static constexpr bool Colored = false;
+    static void Generate(msdfgen::Bitmap<float, 1> &bitmap, const msdfgen::Shape &shape, const msdfgen::SDFTransformation &transform, const msdfgen::MSDFGeneratorConfig &config)
+    {
+        msdfgen::generatePSDF(bitmap, shape, transform, config);
+    }
+    static bool GenerateLinear(msdfgen::Bitmap<float, 1> &, const msdfgen::Shape &, float, msdfgen::Vector2, float, const msdfgen::SDFTransformation &, const msdfgen::MSDFGeneratorConfig &)
+    {
+        return false;
+    }
+};
+
+template <>
+struct FieldTraits<GlyphFieldType::SDF>
+{
+    static constexpr int Channels = 1;
+    static constexpr bool Colored = false;
+    static void Generate(msdfgen::Bitmap<float, 1> &bitmap, const msdfgen::Shape &shape, const msdfgen::SDFTransformation &transform, const msdfgen::MSDFGeneratorConfig &config)
+    {
+        msdfgen::generateSDF(bitmap, shape, transform, config);
+    }
+    static bool GenerateLinear(msdfgen::Bitmap<float, 1> &, const msdfgen::Shape &, float, msdfgen::Vector2, float, const msdfgen::SDFTransformation &, const msdfgen::MSDFGeneratorConfig &)
+    {
+        return false;
+    }
 };
 
+/// @brief Number of channels of a field type
+/// @param field_type GlyphFieldType
+/// @return
+inline int FieldChannels(int field_type)
+{
+    switch (field_type)
+    {
+    case GlyphFieldType::MSDF:
+        return FieldTraits<GlyphFieldType::MSDF>::Channels;
+    case GlyphFieldType::PSDF:
+        return FieldTraits<GlyphFieldType::PSDF>::Channels;
+    case GlyphFieldType::SDF:
+        return FieldTraits<GlyphFieldType::SDF>::Channels;
+    default:
+        return FieldTraits<GlyphFieldType::MTSDF>::Channels;
+    }
+}
+
+inline msdfgen::ErrorCorrectionConfig::Mode GetErrorCorrectionMode(int error_correction)
+{
+    switch (error_correction)
+    {
+    case GlyphErrorCorrection::Disabled:
+        return msdfgen::ErrorCorrectionConfig::DISABLED;
+    case GlyphErrorCorrection::EdgeOnly:
+        return msdfgen::ErrorCorrectionConfig::EDGE_ONLY;
+    case GlyphErrorCorrection::Indiscriminate:
+        return msdfgen::ErrorCorrectionConfig::INDISCRIMINATE;
+    default:
+        return msdfgen::ErrorCorrectionConfig::EDGE_PRIORITY;
+    }
+}
+
 inline byte pixelFloatToByte(float x)
 {
     return byte(~int(255.5f - 255.f * clamp(x)));
 }
 
-void RenderGlyph(FontHandle *fontHandle, GlyphMetrics glyph, AtlasConfig atlas_config, RenderConfig render_config, Buffer<RGBA32Pixel> *refTexture)
+/// @brief Loads the EM-normalized shape of a glyph, only the FreeType access is done under the font lock
+/// @param fontHandle
+/// @param glyphIndex
+/// @param flags Render flags
+/// @param out_resolved Optional, receives whether the shape went through the union and is all line segments
+/// @return
+msdfgen::Shape LoadGlyphShape(FontHandle *fontHandle, int glyphIndex, int flags, bool *out_resolved = nullptr)
 {
-    msdfgen::Shape shape;
-    if (Flag::has(render_config.flags, GlyphRenderFlag::ResolveIntersections))
+    if (out_resolved != nullptr)
+        *out_resolved = false;
+    if (Flag::has(flags, GlyphRenderFlag::ResolveIntersections))
     {
-        shape = GetResolvedShape(fontHandle->ft, glyph.index);
+        bool cached = glyphIndex >= 0 && glyphIndex < static_cast<int>(fontHandle->overlap_cache.size());
+        GlyphOverlap overlap;
+        DecomposeData decompose_data;
+        int units_per_em;
+        {
+            auto lock = fontHandle->Lock();
+            overlap = cached ? fontHandle->overlap_cache[glyphIndex] : GlyphOverlap::Overlapping;
+
+            // Glyphs without overlaps don't need the union, keep their exact curves
+            if (overlap == GlyphOverlap::Clean)
+                return GetOutlineShape(fontHandle->Outline(glyphIndex), fontHandle->units_per_em);
+
+            DecomposeOutline(fontHandle->Outline(glyphIndex), decompose_data);
+            units_per_em = fontHandle->units_per_em;
+        }
+
+        if (overlap == GlyphOverlap::Unknown)
+        {
+            overlap = HasOverlappingContours(decompose_data) ? GlyphOverlap::Overlapping : GlyphOverlap::Clean;
+            auto lock = fontHandle->Lock();
+            fontHandle->overlap_cache[glyphIndex] = overlap;
+            if (overlap == GlyphOverlap::Clean)
+                return GetOutlineShape(fontHandle->Outline(glyphIndex), fontHandle->units_per_em);
+        }
+
+        if (out_resolved != nullptr)
+            *out_resolved = true;
+        return ResolveDecomposedShape(decompose_data, units_per_em);
     }
-    else
+
+    auto lock = fontHandle->Lock();
+    return GetOutlineShape(fontHandle->Outline(glyphIndex), fontHandle->units_per_em);
+}
+
+/// @brief Loads the outline mesh of a glyph, built on first use and cached on the font. Only the FreeType access and
+/// the cache lookup are done under the font lock.
+/// @param fontHandle
+/// @param glyphIndex
+/// @return Triangles of the glyph, valid until the font is unloaded. Empty for glyphs outside the font.
+const std::vector<OutlineVertex> &LoadOutlineMesh(FontHandle *fontHandle, int glyphIndex)
+{
+    static const std::vector<OutlineVertex> empty;
+    if (glyphIndex < 0 || glyphIndex >= static_cast<int>(fontHandle->overlap_cache.size()))
+        return empty;
+
+    QuadOutline outline;
+    DecomposeData decompose_data;
+    GlyphOverlap overlap;
+    int units_per_em;
     {
-        shape = GetShape(fontHandle->ft, glyph.index);
+        auto lock = fontHandle->Lock();
+        auto it = fontHandle->outline_meshes.find(glyphIndex);
+        if (it != fontHandle->outline_meshes.end())
+            return it->second;
+
+        // Overlapping contours only triangulate after the union, which needs the flattened contours
+        overlap = fontHandle->overlap_cache[glyphIndex];
+        FT_Outline *source = fontHandle->Outline(glyphIndex);
+        units_per_em = fontHandle->units_per_em;
+        if (overlap != GlyphOverlap::Clean)
+            DecomposeOutline(source, decompose_data);
+        if (overlap != GlyphOverlap::Overlapping)
+            DecomposeQuadOutline(source, units_per_em, outline);
     }
 
-    edgeColoringSimple(shape, 3.0);
+    if (overlap == GlyphOverlap::Unknown)
+        overlap = HasOverlappingContours(decompose_data) ? GlyphOverlap::Overlapping : GlyphOverlap::Clean;
 
-    float scale = static_cast<float>(atlas_config.glyph_size);
+    std::vector<OutlineVertex> mesh;
+    if (overlap == GlyphOverlap::Clean)
+        TriangulateQuadOutline(outline, units_per_em, mesh);
+    else
+        TriangulateResolvedOutline(decompose_data, units_per_em, mesh);
+
+    auto lock = fontHandle->Lock();
+    fontHandle->overlap_cache[glyphIndex] = overlap;
+    return fontHandle->outline_meshes.emplace(glyphIndex, std::move(mesh)).first->second;
+}
+
+/// @brief Renders a glyph as a distance field into the atlas texture, safe to call from multiple threads as long as the glyph rects don't overlap
+/// @tparam Type Field type, decides the generator and the number of channels written
+/// @param fontHandle
+/// @param glyph
+/// @param atlas_config
+/// @param render_config
+/// @param refTexture Texture of the atlas page the glyph is packed into, FieldTraits<Type>::Channels bytes per pixel
+template <GlyphFieldType Type>
+void RenderGlyph(FontHandle *fontHandle, GlyphMetrics glyph, AtlasConfig atlas_config, RenderConfig render_config, Buffer<Pixel<FieldTraits<Type>::Channels>> *refTexture)
+{
+    constexpr int channels = FieldTraits<Type>::Channels;
+    bool resolved;
+    msdfgen::Shape shape = LoadGlyphShape(fontHandle, glyph.index, render_config.flags, &resolved);
+
+    // Single-channel fields don't use edge colors
+    if (FieldTraits<Type>::Colored)
+        edgeColoringSimple(shape, 3.0);
+
+    float scale = static_cast<float>(GlyphSizePx(glyph, atlas_config));
 
     // Get glyph bounds from Shape (normalized 0-1 units)
     msdfgen::Shape::Bounds bounds = shape.getBounds();
     float translate_x = (atlas_config.padding - bounds.l * scale) / scale;
     float translate_y = (atlas_config.padding - bounds.b * scale) / scale;
     msdfgen::Vector2 translate(translate_x, translate_y);
-    msdfgen::Bitmap<float, 4> tempBitmap(glyph.atlas_width_px, glyph.atlas_height_px);
+    msdfgen::Bitmap<float, channels> tempBitmap(glyph.atlas_width_px, glyph.atlas_height_px);
     msdfgen::Projection projection = msdfgen::Projection(scale, translate);
     msdfgen::SDFTransformation transform(projection, msdfgen::Range(render_config.distance_mapping_range));
-    msdfgen::MSDFGeneratorConfig config(true);
-    msdfgen::generateMTSDF(tempBitmap, shape, transform, config);
+
+    // Resolved shapes have no overlapping contours left, skip the overlap handling for them
+    bool overlap_support = !Flag::has(render_config.flags, GlyphRenderFlag::ResolveIntersections);
+    msdfgen::MSDFGeneratorConfig config(overlap_support, msdfgen::ErrorCorrectionConfig(GetErrorCorrectionMode(render_config.error_correction)));
+
+    // Overlapping glyphs that went through the union are all line segments, those take the single-precision kernel.
+    // Clean glyphs keep their curves and go straight to msdfgen.
+    bool generated = resolved && FieldTraits<Type>::GenerateLinear(tempBitmap, shape, scale, translate, render_config.distance_mapping_range, transform, config);
+    if (!generated)
+        FieldTraits<Type>::Generate(tempBitmap, shape, transform, config);
 
     // Copy from the temp bitmap to the atlas texture
-    for (int dx = 0; dx < glyph.atlas_width_px; ++dx)
+    for (int dy = 0; dy < glyph.atlas_height_px; ++dy)
     {
-        for (int dy = 0; dy < glyph.atlas_height_px; ++dy)
+        int dest_y = glyph.atlas_y_px + dy;
+        if (dest_y < 0 || dest_y >= atlas_config.size)
+            continue;
+
+        for (int dx = 0; dx < glyph.atlas_width_px; ++dx)
         {
             int dest_x = glyph.atlas_x_px + dx;
-            int dest_y = glyph.atlas_y_px + dy;
-            int src_x = dx;
-            int src_y = dy;
-            if (dest_x >= 0 && dest_x < atlas_config.size && dest_y >= 0 && dest_y < atlas_config.size)
-            {
-                auto dest = refTexture->Data() + dest_y * atlas_config.size + dest_x;
-                auto src = tempBitmap(src_x, src_y);
-                dest->r = pixelFloatToByte(src[0]);
-                dest->g = pixelFloatToByte(src[1]);
-                dest->b = pixelFloatToByte(src[2]);
-                dest->a = pixelFloatToByte(src[3]);
-            }
+            if (dest_x < 0 || dest_x >= atlas_config.size)
+                continue;
+
+            auto dest = refTexture->Data() + dest_y * atlas_config.size + dest_x;
+            auto src = tempBitmap(dx, dy);
+            for (int c = 0; c < channels; ++c)
+                dest->channels[c] = pixelFloatToByte(src[c]);
         }
     }
 }
 
+/// @brief Rasterizes a glyph as hinted 8-bit grayscale coverage at atlas_config.glyph_size pixels per em
+/// @param fontHandle
+/// @param glyph Glyph with metrics from GetGlyphBitmapMetrics
+/// @param atlas_config
+/// @param refTexture Single channel texture of the atlas page the glyph is packed into
+void RenderGlyphBitmap(FontHandle *fontHandle, GlyphMetrics glyph, AtlasConfig atlas_config, Buffer<byte> *refTexture)
+{
+    auto lock = fontHandle->Lock();
+    FT_Face face = fontHandle->ft;
+    FT_Set_Pixel_Sizes(face, 0, atlas_config.glyph_size);
+    if (FT_Load_Glyph(face, glyph.index, FT_LOAD_TARGET_NORMAL) != 0)
+        return;
+    if (FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) != 0)
+        return;
+
+    // FreeType rows go top-down while the atlas rows go bottom-up
+    const FT_Bitmap &bitmap = face->glyph->bitmap;
+    int width = std::min(static_cast<int>(bitmap.width), glyph.atlas_width_px - 2 * atlas_config.padding);
+    int rows = std::min(static_cast<int>(bitmap.rows), glyph.atlas_height_px - 2 * atlas_config.padding);
+    for (int row = 0; row < rows; ++row)
+    {
+        int dest_y = glyph.atlas_y_px + atlas_config.padding + (rows - 1 - row);
+        if (dest_y < 0 || dest_y >= atlas_config.size)
+            continue;
+
+        const byte *src = bitmap.buffer + row * bitmap.pitch;
+        for (int col = 0; col < width; ++col)
+        {
+            int dest_x = glyph.atlas_x_px + atlas_config.padding + col;
+            if (dest_x >= 0 && dest_x < atlas_config.size)
+                refTexture->Data()[dest_y * atlas_config.size + dest_x] = src[col];
+        }
+    }
+}
+
+/// @brief Number of bytes per atlas pixel for the render configuration
+/// @param render_config
+/// @return
+inline int AtlasBytesPerPixel(RenderConfig render_config)
+{
+    return Flag::has(render_config.flags, GlyphRenderFlag::RasterizeBitmap) ? 1 : FieldChannels(render_config.field_type);
+}
+
+/// @brief Fills the glyph metrics matching the render mode of the configuration
+/// @param glyphs
+/// @param fontHandle
+/// @param atlas_config
+/// @param render_config
+void GetRenderGlyphMetrics(Buffer<GlyphMetrics> glyphs, FontHandle *fontHandle, AtlasConfig atlas_config, RenderConfig render_config)
+{
+    if (Flag::has(render_config.flags, GlyphRenderFlag::RasterizeBitmap))
+        GetGlyphBitmapMetrics(glyphs, fontHandle, atlas_config.glyph_size, atlas_config.padding);
+    else
+        GetGlyphMetrics(glyphs, fontHandle, atlas_config.glyph_size, atlas_config.padding, atlas_config.min_glyph_size, atlas_config.max_glyph_size);
+}
+
+/// @brief Renders a glyph with the render mode of the configuration
+/// @param fontHandle
+/// @param glyph
+/// @param atlas_config
+/// @param render_config
+/// @param refTexture Atlas page with AtlasBytesPerPixel(render_config) bytes per pixel
+void RenderGlyphToAtlas(FontHandle *fontHandle, GlyphMetrics glyph, AtlasConfig atlas_config, RenderConfig render_config, Buffer<byte> *refTexture)
+{
+    if (Flag::has(render_config.flags, GlyphRenderFlag::RasterizeBitmap))
+    {
+        RenderGlyphBitmap(fontHandle, glyph, atlas_config, refTexture);
+        return;
+    }
+
+    switch (render_config.field_type)
+    {
+    case GlyphFieldType::MSDF:
+        RenderGlyph<GlyphFieldType::MSDF>(fontHandle, glyph, atlas_config, render_config, refTexture->ReinterpretCast<Pixel<3>>());
+        break;
+    case GlyphFieldType::PSDF:
+        RenderGlyph<GlyphFieldType::PSDF>(fontHandle, glyph, atlas_config, render_config, refTexture->ReinterpretCast<Pixel<1>>());
+        break;
+    case GlyphFieldType::SDF:
+        RenderGlyph<GlyphFieldType::SDF>(fontHandle, glyph, atlas_config, render_config, refTexture->ReinterpretCast<Pixel<1>>());
+        break;
+    default:
+        RenderGlyph<GlyphFieldType::MTSDF>(fontHandle, glyph, atlas_config, render_config, refTexture->ReinterpretCast<Pixel<4>>());
+        break;
+    }
+}
+
 #endif
\ No newline at end of file
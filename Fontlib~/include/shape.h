@@ -1,6 +1,8 @@
 #ifndef SHAPE_H
 #define SHAPE_H
 
+#include <algorithm>
+#include <vector>
 #include <msdfgen.h>
 #include <msdfgen-ext.h>
 #include "clipper2/clipper.h"
@@ -181,17 +183,47 @@ msdfgen::Shape ConvertClipperPathsToMsdfShapeEMNormalized(
     return shape;
 }
 
-msdfgen::Shape GetResolvedShape(FT_Face face, int glyphIndex)
+/**
+ * Flattens an unscaled outline into contours in font units.
+ *
+ * @param outline The outline, e.g. from FontHandle::Outline. Null leaves the contours empty.
+ * @param decompose_data Receives the flattened contours.
+ */
+void DecomposeOutline(FT_Outline *outline, DecomposeData &decompose_data)
 {
-    FT_Load_Glyph(face, glyphIndex, FT_LOAD_NO_SCALE);
-    FT_Outline *outline = &face->glyph->outline;
-    DecomposeData decompose_data;
+    if (outline == nullptr)
+        return;
     FT_Outline_Funcs decompose_callbacks = {};
     decompose_callbacks.move_to = MoveToFunc;
     decompose_callbacks.line_to = LineToFunc;
     decompose_callbacks.conic_to = ConicToFunc;
     decompose_callbacks.cubic_to = CubicToFunc;
     FT_Outline_Decompose(outline, &decompose_callbacks, &decompose_data);
+}
+
+/**
+ * Decomposes the outline of a glyph into flattened contours in font units.
+ *
+ * @param face The FreeType face, must not be used by another thread during the call.
+ * @param glyphIndex Index of the glyph in the face.
+ * @param decompose_data Receives the flattened contours.
+ */
+void DecomposeGlyph(FT_Face face, int glyphIndex, DecomposeData &decompose_data)
+{
+    FT_Load_Glyph(face, glyphIndex, FT_LOAD_NO_SCALE);
+    DecomposeOutline(&face->glyph->outline, decompose_data);
+}
+
+/**
+ * Unions the flattened contours of a glyph so that overlapping contours are merged.
+ * Does not touch the FreeType face, so it can run without holding the font lock.
+ *
+ * @param decompose_data The flattened contours from DecomposeGlyph.
+ * @param units_per_EM Units per EM of the font.
+ * @return An EM-normalized msdfgen::Shape without overlaps.
+ */
+msdfgen::Shape ResolveDecomposedShape(const DecomposeData &decompose_data, int units_per_EM)
+{
     Clipper2Lib::Paths64 clipper_paths;
     clipper_paths.reserve(decompose_data.contours.size());
     for (const auto &contour_d : decompose_data.contours)
@@ -216,7 +248,183 @@ msdfgen::Shape GetResolvedShape(FT_Face face, int glyphIndex)
 
     return ConvertClipperPathsToMsdfShapeEMNormalized(
         solution_paths,
-        face->units_per_EM);
+        units_per_EM);
+}
+
+struct SegmentD
+{
+    PointD a, b;
+    double min_x, max_x, min_y, max_y;
+    int contour;
+    int index; // Position of the segment in its contour
+};
+
+double Cross(const PointD &o, const PointD &a, const PointD &b)
+{
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+bool OnSegment(const PointD &a, const PointD &b, const PointD &p)
+{
+    return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) &&
+           std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+}
+
+/**
+ * Tests whether two segments cross or touch.
+ */
+bool SegmentsIntersect(const SegmentD &s, const SegmentD &t)
+{
+    double d1 = Cross(t.a, t.b, s.a);
+    double d2 = Cross(t.a, t.b, s.b);
+    double d3 = Cross(s.a, s.b, t.a);
+    double d4 = Cross(s.a, s.b, t.b);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0)))
+        return true;
+
+    return (d1 == 0 && OnSegment(t.a, t.b, s.a)) ||
+           (d2 == 0 && OnSegment(t.a, t.b, s.b)) ||
+           (d3 == 0 && OnSegment(s.a, s.b, t.a)) ||
+           (d4 == 0 && OnSegment(s.a, s.b, t.b));
+}
+
+/**
+ * Tells whether the flattened contours of a glyph overlap each other or themselves, i.e. whether the glyph needs
+ * the Clipper union before it can be rendered without overlap artifacts. Errs on the side of reporting an overlap.
+ *
+ * Contours whose bounding boxes are disjoint are never compared. The remaining segments are checked with a sweep
+ * along x, which only tests segments whose x and y extents overlap.
+ *
+ * @param decompose_data The flattened contours from DecomposeGlyph.
+ * @return True if any two contours cross, a contour crosses itself, or a contour sits inside another one with the same winding.
+ */
+bool HasOverlappingContours(const DecomposeData &decompose_data)
+{
+    struct ContourInfo
+    {
+        double l, b, r, t;
+        double area; // Signed, the sign gives the winding
+        int segment_count;
+    };
+
+    const auto &contours = decompose_data.contours;
+    std::vector<ContourInfo> infos(contours.size());
+    size_t total_segments = 0;
+    for (size_t c = 0; c < contours.size(); c++)
+    {
+        const auto &path = contours[c];
+        ContourInfo &info = infos[c];
+        info = {0, 0, 0, 0, 0, 0};
+        if (path.size() < 3)
+            continue;
+
+        info.l = info.r = path[0].x;
+        info.b = info.t = path[0].y;
+        for (size_t i = 0; i < path.size(); i++)
+        {
+            const PointD &p = path[i];
+            const PointD &q = path[(i + 1) % path.size()];
+            info.l = std::min(info.l, p.x);
+            info.r = std::max(info.r, p.x);
+            info.b = std::min(info.b, p.y);
+            info.t = std::max(info.t, p.y);
+            info.area += p.x * q.y - q.x * p.y;
+        }
+
+        // Outlines usually repeat the start point, the closing segment is only needed when they don't
+        info.segment_count = static_cast<int>(path.back() == path.front() ? path.size() - 1 : path.size());
+        total_segments += info.segment_count;
+    }
+
+    auto boxes_overlap = [&](int i, int j)
+    {
+        return infos[i].l <= infos[j].r && infos[j].l <= infos[i].r && infos[i].b <= infos[j].t && infos[j].b <= infos[i].t;
+    };
+
+    // A contour nested inside another with the same winding overlaps it without any crossing edge
+    for (size_t i = 0; i < infos.size(); i++)
+    {
+        for (size_t j = 0; j < infos.size(); j++)
+        {
+            if (i == j || infos[i].segment_count == 0 || infos[j].segment_count == 0)
+                continue;
+            bool inside = infos[j].l <= infos[i].l && infos[i].r <= infos[j].r && infos[j].b <= infos[i].b && infos[i].t <= infos[j].t;
+            if (inside && (infos[i].area > 0) == (infos[j].area > 0))
+                return true;
+        }
+    }
+
+    std::vector<SegmentD> segments;
+    segments.reserve(total_segments);
+    for (size_t c = 0; c < contours.size(); c++)
+    {
+        const auto &path = contours[c];
+        for (int i = 0; i < infos[c].segment_count; i++)
+        {
+            const PointD &a = path[i];
+            const PointD &b = path[(i + 1) % path.size()];
+            segments.push_back({a, b, std::min(a.x, b.x), std::max(a.x, b.x), std::min(a.y, b.y), std::max(a.y, b.y), static_cast<int>(c), i});
+        }
+    }
+    std::sort(segments.begin(), segments.end(), [](const SegmentD &s, const SegmentD &t)
+              { return s.min_x < t.min_x; });
+
+    std::vector<const SegmentD *> active;
+    for (const SegmentD &s : segments)
+    {
+        // Drop the segments that end before this one starts
+        active.erase(std::remove_if(active.begin(), active.end(), [&](const SegmentD *t)
+                                    { return t->max_x < s.min_x; }),
+                     active.end());
+
+        for (const SegmentD *t : active)
+        {
+            if (t->max_y < s.min_y || s.max_y < t->min_y)
+                continue;
+
+            if (t->contour == s.contour)
+            {
+                // Neighbouring segments of a contour always share a point
+                int count = infos[s.contour].segment_count;
+                if ((t->index + 1) % count == s.index || (s.index + 1) % count == t->index)
+                    continue;
+            }
+            else if (!boxes_overlap(t->contour, s.contour))
+            {
+                continue;
+            }
+
+            if (SegmentsIntersect(s, *t))
+                return true;
+        }
+        active.push_back(&s);
+    }
+
+    return false;
+}
+
+msdfgen::Shape GetResolvedShape(FT_Face face, int glyphIndex)
+{
+    DecomposeData decompose_data;
+    DecomposeGlyph(face, glyphIndex, decompose_data);
+    return ResolveDecomposedShape(decompose_data, face->units_per_EM);
+}
+
+/**
+ * Converts an unscaled outline into an EM-normalized msdfgen::Shape with its exact curves, like GetShape does for a
+ * glyph loaded through msdfgen.
+ *
+ * @param outline The outline, e.g. from FontHandle::Outline. Null gives an empty shape.
+ * @param units_per_EM Units per EM of the font.
+ */
+msdfgen::Shape GetOutlineShape(FT_Outline *outline, int units_per_EM)
+{
+    msdfgen::Shape shape;
+    if (outline == nullptr || units_per_EM <= 0)
+        return shape;
+    msdfgen::readFreetypeOutline(shape, outline, 1.0 / units_per_EM);
+    shape.normalize();
+    return shape;
 }
 
 msdfgen::Shape GetShape(FT_Face face, int glyphIndex)
@@ -228,6 +436,7 @@ msdfgen::Shape GetShape(FT_Face face, int glyphIndex)
         font_handle,
         msdfgen::GlyphIndex(glyphIndex),
         msdfgen::FontCoordinateScaling::FONT_SCALING_EM_NORMALIZED);
+    msdfgen::destroyFont(font_handle);
     shape.normalize();
     return shape;
 }
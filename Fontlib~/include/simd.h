@@ -0,0 +1,179 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <math.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SIMD_NEON 1
+#else
+#include <string.h>
+#endif
+
+/// @brief Eight floats processed together, one AVX register, two SSE2 or NEON registers, or plain scalars elsewhere.
+/// Comparisons return masks with all bits set in the true lanes, for Select.
+struct Float8
+{
+#if SIMD_AVX
+    __m256 v;
+
+    Float8() = default;
+    Float8(__m256 v) : v(v) {}
+    Float8(float x) : v(_mm256_set1_ps(x)) {}
+    static Float8 Load(const float *p) { return _mm256_loadu_ps(p); }
+    void Store(float *p) const { _mm256_storeu_ps(p, v); }
+
+    friend Float8 operator+(Float8 a, Float8 b) { return _mm256_add_ps(a.v, b.v); }
+    friend Float8 operator-(Float8 a, Float8 b) { return _mm256_sub_ps(a.v, b.v); }
+    friend Float8 operator*(Float8 a, Float8 b) { return _mm256_mul_ps(a.v, b.v); }
+    friend Float8 operator/(Float8 a, Float8 b) { return _mm256_div_ps(a.v, b.v); }
+    friend Float8 operator&(Float8 a, Float8 b) { return _mm256_and_ps(a.v, b.v); }
+    friend Float8 operator|(Float8 a, Float8 b) { return _mm256_or_ps(a.v, b.v); }
+    friend Float8 operator<(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+    friend Float8 operator>(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+    friend Float8 operator<=(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+    friend Float8 operator>=(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+    friend Float8 operator==(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+    friend Float8 Min(Float8 a, Float8 b) { return _mm256_min_ps(a.v, b.v); }
+    friend Float8 Max(Float8 a, Float8 b) { return _mm256_max_ps(a.v, b.v); }
+    friend Float8 Sqrt(Float8 a) { return _mm256_sqrt_ps(a.v); }
+    friend Float8 Abs(Float8 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+    friend Float8 Select(Float8 mask, Float8 a, Float8 b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+#elif SIMD_SSE2
+    __m128 lo, hi;
+
+    Float8() = default;
+    Float8(__m128 lo, __m128 hi) : lo(lo), hi(hi) {}
+    Float8(float x) : lo(_mm_set1_ps(x)), hi(lo) {}
+    static Float8 Load(const float *p) { return {_mm_loadu_ps(p), _mm_loadu_ps(p + 4)}; }
+    void Store(float *p) const { _mm_storeu_ps(p, lo), _mm_storeu_ps(p + 4, hi); }
+
+    friend Float8 operator+(Float8 a, Float8 b) { return {_mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi)}; }
+    friend Float8 operator-(Float8 a, Float8 b) { return {_mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi)}; }
+    friend Float8 operator*(Float8 a, Float8 b) { return {_mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi)}; }
+    friend Float8 operator/(Float8 a, Float8 b) { return {_mm_div_ps(a.lo, b.lo), _mm_div_ps(a.hi, b.hi)}; }
+    friend Float8 operator&(Float8 a, Float8 b) { return {_mm_and_ps(a.lo, b.lo), _mm_and_ps(a.hi, b.hi)}; }
+    friend Float8 operator|(Float8 a, Float8 b) { return {_mm_or_ps(a.lo, b.lo), _mm_or_ps(a.hi, b.hi)}; }
+    friend Float8 operator<(Float8 a, Float8 b) { return {_mm_cmplt_ps(a.lo, b.lo), _mm_cmplt_ps(a.hi, b.hi)}; }
+    friend Float8 operator>(Float8 a, Float8 b) { return {_mm_cmpgt_ps(a.lo, b.lo), _mm_cmpgt_ps(a.hi, b.hi)}; }
+    friend Float8 operator<=(Float8 a, Float8 b) { return {_mm_cmple_ps(a.lo, b.lo), _mm_cmple_ps(a.hi, b.hi)}; }
+    friend Float8 operator>=(Float8 a, Float8 b) { return {_mm_cmpge_ps(a.lo, b.lo), _mm_cmpge_ps(a.hi, b.hi)}; }
+    friend Float8 operator==(Float8 a, Float8 b) { return {_mm_cmpeq_ps(a.lo, b.lo), _mm_cmpeq_ps(a.hi, b.hi)}; }
+    friend Float8 Min(Float8 a, Float8 b) { return {_mm_min_ps(a.lo, b.lo), _mm_min_ps(a.hi, b.hi)}; }
+    friend Float8 Max(Float8 a, Float8 b) { return {_mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi)}; }
+    friend Float8 Sqrt(Float8 a) { return {_mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi)}; }
+    friend Float8 Abs(Float8 a)
+    {
+        __m128 sign = _mm_set1_ps(-0.0f);
+        return {_mm_andnot_ps(sign, a.lo), _mm_andnot_ps(sign, a.hi)};
+    }
+    friend Float8 Select(Float8 mask, Float8 a, Float8 b)
+    {
+        return {_mm_or_ps(_mm_and_ps(mask.lo, a.lo), _mm_andnot_ps(mask.lo, b.lo)),
+                _mm_or_ps(_mm_and_ps(mask.hi, a.hi), _mm_andnot_ps(mask.hi, b.hi))};
+    }
+#elif SIMD_NEON
+    float32x4_t lo, hi;
+
+    Float8() = default;
+    Float8(float32x4_t lo, float32x4_t hi) : lo(lo), hi(hi) {}
+    Float8(float x) : lo(vdupq_n_f32(x)), hi(lo) {}
+    static Float8 Load(const float *p) { return {vld1q_f32(p), vld1q_f32(p + 4)}; }
+    void Store(float *p) const { vst1q_f32(p, lo), vst1q_f32(p + 4, hi); }
+
+    friend Float8 operator+(Float8 a, Float8 b) { return {vaddq_f32(a.lo, b.lo), vaddq_f32(a.hi, b.hi)}; }
+    friend Float8 operator-(Float8 a, Float8 b) { return {vsubq_f32(a.lo, b.lo), vsubq_f32(a.hi, b.hi)}; }
+    friend Float8 operator*(Float8 a, Float8 b) { return {vmulq_f32(a.lo, b.lo), vmulq_f32(a.hi, b.hi)}; }
+    friend Float8 operator/(Float8 a, Float8 b) { return {vdivq_f32(a.lo, b.lo), vdivq_f32(a.hi, b.hi)}; }
+    friend Float8 operator&(Float8 a, Float8 b) { return Bits(vandq_u32(U32(a.lo), U32(b.lo)), vandq_u32(U32(a.hi), U32(b.hi))); }
+    friend Float8 operator|(Float8 a, Float8 b) { return Bits(vorrq_u32(U32(a.lo), U32(b.lo)), vorrq_u32(U32(a.hi), U32(b.hi))); }
+    friend Float8 operator<(Float8 a, Float8 b) { return Bits(vcltq_f32(a.lo, b.lo), vcltq_f32(a.hi, b.hi)); }
+    friend Float8 operator>(Float8 a, Float8 b) { return Bits(vcgtq_f32(a.lo, b.lo), vcgtq_f32(a.hi, b.hi)); }
+    friend Float8 operator<=(Float8 a, Float8 b) { return Bits(vcleq_f32(a.lo, b.lo), vcleq_f32(a.hi, b.hi)); }
+    friend Float8 operator>=(Float8 a, Float8 b) { return Bits(vcgeq_f32(a.lo, b.lo), vcgeq_f32(a.hi, b.hi)); }
+    friend Float8 operator==(Float8 a, Float8 b) { return Bits(vceqq_f32(a.lo, b.lo), vceqq_f32(a.hi, b.hi)); }
+    friend Float8 Min(Float8 a, Float8 b) { return {vminq_f32(a.lo, b.lo), vminq_f32(a.hi, b.hi)}; }
+    friend Float8 Max(Float8 a, Float8 b) { return {vmaxq_f32(a.lo, b.lo), vmaxq_f32(a.hi, b.hi)}; }
+    friend Float8 Sqrt(Float8 a) { return {vsqrtq_f32(a.lo), vsqrtq_f32(a.hi)}; }
+    friend Float8 Abs(Float8 a) { return {vabsq_f32(a.lo), vabsq_f32(a.hi)}; }
+    friend Float8 Select(Float8 mask, Float8 a, Float8 b) { return {vbslq_f32(U32(mask.lo), a.lo, b.lo), vbslq_f32(U32(mask.hi), a.hi, b.hi)}; }
+
+private:
+    static uint32x4_t U32(float32x4_t x) { return vreinterpretq_u32_f32(x); }
+    static Float8 Bits(uint32x4_t lo, uint32x4_t hi) { return {vreinterpretq_f32_u32(lo), vreinterpretq_f32_u32(hi)}; }
+#else
+    float v[8];
+
+    Float8() = default;
+    Float8(float x)
+    {
+        for (float &lane : v)
+            lane = x;
+    }
+    static Float8 Load(const float *p)
+    {
+        Float8 r;
+        for (int i = 0; i < 8; i++)
+            r.v[i] = p[i];
+        return r;
+    }
+    void Store(float *p) const
+    {
+        for (int i = 0; i < 8; i++)
+            p[i] = v[i];
+    }
+
+    template <typename F>
+    static Float8 Map(Float8 a, Float8 b, F f)
+    {
+        Float8 r;
+        for (int i = 0; i < 8; i++)
+            r.v[i] = f(a.v[i], b.v[i]);
+        return r;
+    }
+    static float Mask(bool x) { return x ? FromBits(~0u) : 0.0f; }
+    static unsigned ToBits(float x)
+    {
+        unsigned bits;
+        memcpy(&bits, &x, sizeof(bits));
+        return bits;
+    }
+    static float FromBits(unsigned bits)
+    {
+        float x;
+        memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    friend Float8 operator+(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+    friend Float8 operator-(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+    friend Float8 operator*(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+    friend Float8 operator/(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+    friend Float8 operator&(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return FromBits(ToBits(x) & ToBits(y)); }); }
+    friend Float8 operator|(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return FromBits(ToBits(x) | ToBits(y)); }); }
+    friend Float8 operator<(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return Mask(x < y); }); }
+    friend Float8 operator>(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return Mask(x > y); }); }
+    friend Float8 operator<=(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return Mask(x <= y); }); }
+    friend Float8 operator>=(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return Mask(x >= y); }); }
+    friend Float8 operator==(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return Mask(x == y); }); }
+    friend Float8 Min(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return y < x ? y : x; }); }
+    friend Float8 Max(Float8 a, Float8 b) { return Map(a, b, [](float x, float y) { return y > x ? y : x; }); }
+    friend Float8 Sqrt(Float8 a) { return Map(a, a, [](float x, float) { return sqrtf(x); }); }
+    friend Float8 Abs(Float8 a) { return Map(a, a, [](float x, float) { return fabsf(x); }); }
+    friend Float8 Select(Float8 mask, Float8 a, Float8 b)
+    {
+        Float8 r;
+        for (int i = 0; i < 8; i++)
+            r.v[i] = ToBits(mask.v[i]) ? a.v[i] : b.v[i];
+        return r;
+    }
+#endif
+};
+
+#endif
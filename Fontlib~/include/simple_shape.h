@@ -0,0 +1,215 @@
+#ifndef SIMPLE_SHAPE_H
+#define SIMPLE_SHAPE_H
+
+#include <algorithm>
+#include <iterator>
+#include <stdint.h>
+#include <vector>
+#include "base.h"
+#include "hb.h"
+#include "hb-ot.h"
+
+const hb_codepoint_t SIMPLE_SHAPE_FIRST = 0x20; // Space, controls below it always go through HarfBuzz
+const hb_codepoint_t SIMPLE_SHAPE_END = 0x100;  // End of Latin-1
+const int SIMPLE_SHAPE_COUNT = SIMPLE_SHAPE_END - SIMPLE_SHAPE_FIRST;
+
+/// @brief GPOS lookup type of a lookup, extension lookups resolved to the type they wrap
+/// @param data GPOS table
+/// @param length
+/// @param lookup_index
+/// @return 0 if the table is malformed
+inline unsigned GposLookupType(const byte *data, unsigned length, unsigned lookup_index)
+{
+    if (data == nullptr || length < 10)
+        return 0;
+    unsigned lookup_list = ReadUInt16BE(data + 8);
+    if (lookup_list + 2 > length || lookup_index >= ReadUInt16BE(data + lookup_list) || lookup_list + 4 + 2 * lookup_index > length)
+        return 0;
+    unsigned lookup = lookup_list + ReadUInt16BE(data + lookup_list + 2 + 2 * lookup_index);
+    if (lookup + 8 > length)
+        return 0;
+
+    unsigned type = ReadUInt16BE(data + lookup);
+    const unsigned extension = 9;
+    if (type == extension && ReadUInt16BE(data + lookup + 4) > 0)
+    {
+        unsigned subtable = lookup + ReadUInt16BE(data + lookup + 6);
+        type = subtable + 4 <= length ? ReadUInt16BE(data + subtable + 2) : 0;
+    }
+    return type;
+}
+
+/// @brief Shaping tables for text made of Latin-1 characters that no GSUB lookup and no GPOS lookup other than pair
+/// kerning touches. Such text shapes to the nominal glyphs with their advances plus the kerning of each pair, which
+/// the tables answer with plain lookups instead of running the HarfBuzz shaper.
+struct SimpleShapeTable
+{
+    uint32_t glyphs[SIMPLE_SHAPE_COUNT] = {}; // Nominal glyph per codepoint, 0 if the codepoint needs HarfBuzz
+    int32_t advances[SIMPLE_SHAPE_COUNT] = {};
+    std::vector<int16_t> kerning;             // Advance adjustment of the left glyph, [left * SIMPLE_SHAPE_COUNT + right], empty without kerning
+
+    /// @brief Builds the tables for a font, the shaping setup has to match Context::ShapeBuffer
+    /// @param font HarfBuzz font at its default scale of units per em
+    void Build(hb_font_t *font)
+    {
+        hb_face_t *face = hb_font_get_face(font);
+
+        // Lookups of the features HarfBuzz enables by default for horizontal Latin text
+        const hb_tag_t scripts[] = {HB_TAG('l', 'a', 't', 'n'), HB_OT_TAG_DEFAULT_SCRIPT, HB_TAG_NONE};
+        const hb_tag_t languages[] = {HB_TAG('E', 'N', 'G', ' '), HB_OT_TAG_DEFAULT_LANGUAGE, HB_TAG_NONE};
+        const hb_tag_t features[] = {
+            HB_TAG('a', 'b', 'v', 'm'), HB_TAG('b', 'l', 'w', 'm'), HB_TAG('c', 'c', 'm', 'p'), HB_TAG('l', 'o', 'c', 'l'),
+            HB_TAG('m', 'a', 'r', 'k'), HB_TAG('m', 'k', 'm', 'k'), HB_TAG('r', 'l', 'i', 'g'), HB_TAG('r', 'v', 'r', 'n'),
+            HB_TAG('c', 'a', 'l', 't'), HB_TAG('c', 'l', 'i', 'g'), HB_TAG('c', 'u', 'r', 's'), HB_TAG('d', 'i', 's', 't'),
+            HB_TAG('k', 'e', 'r', 'n'), HB_TAG('l', 'i', 'g', 'a'), HB_TAG('r', 'c', 'l', 't'), HB_TAG_NONE};
+
+        // Glyphs that a substitution or a non-kerning positioning lookup may act on
+        hb_set_t *complex = hb_set_create();
+        hb_set_t *lookups = hb_set_create();
+        hb_codepoint_t lookup = HB_SET_VALUE_INVALID;
+        hb_ot_layout_collect_lookups(face, HB_OT_TAG_GSUB, scripts, languages, features, lookups);
+        while (hb_set_next(lookups, &lookup))
+            hb_ot_layout_lookup_collect_glyphs(face, HB_OT_TAG_GSUB, lookup, nullptr, complex, nullptr, nullptr);
+
+        hb_set_clear(lookups);
+        hb_blob_t *gpos = hb_face_reference_table(face, HB_OT_TAG_GPOS);
+        unsigned gpos_length;
+        const byte *gpos_data = reinterpret_cast<const byte *>(hb_blob_get_data(gpos, &gpos_length));
+        bool pair_kerning = false;
+        hb_ot_layout_collect_lookups(face, HB_OT_TAG_GPOS, scripts, languages, features, lookups);
+        lookup = HB_SET_VALUE_INVALID;
+        while (hb_set_next(lookups, &lookup))
+        {
+            // Pair kerning is measured below, mark attachment needs combining marks which Latin-1 doesn't have
+            const unsigned pair = 2, mark_to_base = 4, mark_to_ligature = 5, mark_to_mark = 6;
+            unsigned type = GposLookupType(gpos_data, gpos_length, lookup);
+            if (type == pair)
+                pair_kerning = true;
+            else if (type != mark_to_base && type != mark_to_ligature && type != mark_to_mark)
+                hb_ot_layout_lookup_collect_glyphs(face, HB_OT_TAG_GPOS, lookup, nullptr, complex, nullptr, nullptr);
+        }
+        hb_blob_destroy(gpos);
+        hb_set_destroy(lookups);
+
+        // Soft hyphen and the C1 controls are default ignorables or controls, HarfBuzz hides them. Glyphs classified
+        // as marks get zero advances and are skipped by kerning.
+        std::vector<hb_codepoint_t> simple;
+        for (hb_codepoint_t codepoint = SIMPLE_SHAPE_FIRST; codepoint < SIMPLE_SHAPE_END; codepoint++)
+        {
+            hb_codepoint_t glyph;
+            if ((codepoint >= 0x7F && codepoint < 0xA0) || codepoint == 0xAD)
+                continue;
+            if (!hb_font_get_nominal_glyph(font, codepoint, &glyph) || glyph == 0 || hb_set_has(complex, glyph) ||
+                hb_ot_layout_get_glyph_class(face, glyph) == HB_OT_LAYOUT_GLYPH_CLASS_MARK)
+                continue;
+            glyphs[codepoint - SIMPLE_SHAPE_FIRST] = glyph;
+            advances[codepoint - SIMPLE_SHAPE_FIRST] = hb_font_get_glyph_h_advance(font, glyph);
+            simple.push_back(codepoint);
+        }
+        hb_set_destroy(complex);
+
+        hb_blob_t *kern = hb_face_reference_table(face, HB_TAG('k', 'e', 'r', 'n'));
+        bool kern_table = hb_blob_get_length(kern) > 0;
+        hb_blob_destroy(kern);
+        if ((pair_kerning || kern_table) && !MeasureKerning(font, simple))
+        {
+            // The kerning isn't plain pair kerning on the left glyph's advance, leave everything to HarfBuzz
+            std::fill(std::begin(glyphs), std::end(glyphs), 0);
+            kerning.clear();
+        }
+    }
+
+    /// @brief Shapes a buffer of Latin-1 codepoints in place
+    /// @param buffer Buffer holding codepoints, as after hb_buffer_add_utf8
+    /// @return False if a codepoint needs HarfBuzz, the buffer is untouched and has to go through hb_shape
+    bool Shape(hb_buffer_t *buffer) const
+    {
+        unsigned count;
+        hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(buffer, &count);
+        for (unsigned i = 0; i < count; i++)
+        {
+            hb_codepoint_t slot = infos[i].codepoint - SIMPLE_SHAPE_FIRST;
+            if (slot >= static_cast<hb_codepoint_t>(SIMPLE_SHAPE_COUNT) || glyphs[slot] == 0)
+                return false;
+        }
+
+        hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(buffer, &count);
+        hb_codepoint_t previous = 0;
+        for (unsigned i = 0; i < count; i++)
+        {
+            hb_codepoint_t slot = infos[i].codepoint - SIMPLE_SHAPE_FIRST;
+            infos[i].codepoint = glyphs[slot];
+            positions[i] = hb_glyph_position_t{};
+            positions[i].x_advance = advances[slot];
+            if (i > 0 && !kerning.empty())
+                positions[i - 1].x_advance += kerning[previous * SIMPLE_SHAPE_COUNT + slot];
+            previous = slot;
+        }
+        hb_buffer_set_content_type(buffer, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+        return true;
+    }
+
+private:
+    /// @brief Reads the pair adjustments of the simple codepoints from HarfBuzz itself. Shaping "L r1 L r2 ... L rn L"
+    /// gives kern(L, ri) on every L and kern(ri, L) on every ri, so each codepoint needs one run. Every pair is seen
+    /// in two runs with different neighbours, the two only agree if no lookup adjusts the second glyph of a pair.
+    /// @return False if the shaped runs hold anything besides adjustments of the left glyph's advance
+    bool MeasureKerning(hb_font_t *font, const std::vector<hb_codepoint_t> &simple)
+    {
+        kerning.assign(static_cast<size_t>(SIMPLE_SHAPE_COUNT) * SIMPLE_SHAPE_COUNT, 0);
+        std::vector<char> measured(kerning.size(), 0);
+        hb_buffer_t *buffer = hb_buffer_create();
+        std::vector<hb_codepoint_t> run;
+        bool kerned = false;
+        bool valid = true;
+
+        for (size_t l = 0; l < simple.size() && valid; l++)
+        {
+            hb_codepoint_t left = simple[l];
+            run.clear();
+            for (hb_codepoint_t right : simple)
+            {
+                run.push_back(left);
+                run.push_back(right);
+            }
+            run.push_back(left);
+
+            hb_buffer_clear_contents(buffer);
+            hb_buffer_add_codepoints(buffer, run.data(), static_cast<int>(run.size()), 0, static_cast<int>(run.size()));
+            hb_buffer_set_direction(buffer, HB_DIRECTION_LTR);
+            hb_buffer_set_script(buffer, HB_SCRIPT_LATIN);
+            hb_buffer_set_language(buffer, hb_language_from_string("en", -1));
+            hb_shape(font, buffer, nullptr, 0);
+
+            unsigned count;
+            hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(buffer, &count);
+            hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(buffer, &count);
+            valid = count == run.size();
+
+            for (unsigned i = 0; i < count && valid; i++)
+            {
+                hb_codepoint_t slot = run[i] - SIMPLE_SHAPE_FIRST;
+                const auto &position = positions[i];
+                valid = infos[i].codepoint == glyphs[slot] && position.x_offset == 0 && position.y_offset == 0 && position.y_advance == 0;
+                if (valid && i + 1 == count)
+                    valid = position.x_advance == advances[slot];
+                if (!valid || i + 1 == count)
+                    continue;
+
+                size_t pair = slot * SIMPLE_SHAPE_COUNT + (run[i + 1] - SIMPLE_SHAPE_FIRST);
+                int32_t adjustment = position.x_advance - advances[slot];
+                valid = adjustment >= INT16_MIN && adjustment <= INT16_MAX && (!measured[pair] || kerning[pair] == adjustment);
+                kerning[pair] = static_cast<int16_t>(adjustment);
+                measured[pair] = 1;
+                kerned |= adjustment != 0;
+            }
+        }
+
+        hb_buffer_destroy(buffer);
+        if (!kerned)
+            kerning.clear();
+        return valid;
+    }
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef SUBSET_H
+#define SUBSET_H
+
+#include <stdint.h>
+#include "hb.h"
+#include "hb-subset.h"
+#include "base.h"
+#include "buffer.h"
+#include "glyph.h"
+
+enum SubsetFlag
+{
+    DropHinting = 1 << 0,    // Strip TrueType instructions and CFF hints, only bitmap rendering uses them
+    PinVariations = 1 << 1,  // Instance variable fonts at their default axis values and drop the variation tables
+    RetainGlyphIds = 1 << 2, // Keep the original glyph ids so atlases baked from the full font stay valid
+};
+
+/// @brief Builds a font that only holds the glyphs of the given codepoints and glyph ids. Glyphs reachable through
+/// GSUB (ligatures, alternates) and composite components are kept by HarfBuzz's glyph closure.
+/// @param font_data Font file
+/// @param face_index Face index for TrueType collections, 0 for single fonts
+/// @param ranges Codepoint ranges, inclusive
+/// @param range_count
+/// @param glyphs Extra glyph ids to keep, e.g. from shaped samples, may be null
+/// @param glyph_count
+/// @param flags SubsetFlag
+/// @return The subset font file, null on failure, release with hb_blob_destroy
+hb_blob_t *SubsetFontData(Buffer<byte> font_data, int face_index, const UnicodeRange *ranges, int range_count, const int *glyphs, int glyph_count, int flags)
+{
+    hb_subset_input_t *input = hb_subset_input_create_or_fail();
+    if (input == nullptr)
+        return nullptr;
+
+    auto blob = hb_blob_create((const char *)font_data.Data(), font_data.SizeInBytes(), HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+    auto face = hb_face_create(blob, face_index);
+    hb_blob_destroy(blob);
+
+    hb_set_t *unicodes = hb_subset_input_unicode_set(input);
+    for (int i = 0; i < range_count; i++)
+        hb_set_add_range(unicodes, ranges[i].start, ranges[i].end);
+
+    hb_set_t *glyph_set = hb_subset_input_glyph_set(input);
+    for (int i = 0; i < glyph_count; i++)
+        hb_set_add(glyph_set, glyphs[i]);
+
+    unsigned subset_flags = HB_SUBSET_FLAGS_DEFAULT;
+    if (Flag::has(flags, SubsetFlag::DropHinting))
+        subset_flags |= HB_SUBSET_FLAGS_NO_HINTING;
+    if (Flag::has(flags, SubsetFlag::RetainGlyphIds))
+        subset_flags |= HB_SUBSET_FLAGS_RETAIN_GIDS;
+    hb_subset_input_set_flags(input, subset_flags);
+    if (Flag::has(flags, SubsetFlag::PinVariations))
+        hb_subset_input_pin_all_axes_to_default(input, face);
+
+    hb_blob_t *result = nullptr;
+    hb_face_t *subset = hb_subset_or_fail(face, input);
+    if (subset != nullptr)
+    {
+        // Serializes the subset tables into a single font file
+        result = hb_face_reference_blob(subset);
+        hb_face_destroy(subset);
+        if (hb_blob_get_length(result) == 0)
+        {
+            hb_blob_destroy(result);
+            result = nullptr;
+        }
+    }
+
+    hb_subset_input_destroy(input);
+    hb_face_destroy(face);
+    return result;
+}
+
+#endif
@@ -0,0 +1,380 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "bake.h"
+
+// fontlib-bake: offline atlas baker, renders every font x glyph size combination on all cores
+// and writes one .fontatlas file per combination (see BakedAtlasHeader for the layout).
+
+static void PrintUsage()
+{
+    std::cerr
+        << "Usage: fontlib-bake [options] <font>...\n"
+        << "  -o, --out <dir>           Output directory (default: .)\n"
+        << "  -r, --ranges <list>       Hex codepoint ranges, e.g. 0020-007E,00A0-00FF (default: 0020-007E)\n"
+        << "  -t, --text <file>         UTF-8 sample text, shaped to pick up ligatures and alternates\n"
+        << "  -s, --glyph-size <list>   Glyph sizes in pixels per em, comma separated (default: 32)\n"
+        << "      --min-glyph-size <px> Adaptive sizing: smallest pixels per em a simple glyph may get\n"
+        << "      --max-glyph-size <px> Adaptive sizing: largest pixels per em a complex glyph may get\n"
+        << "      --size <px>           Atlas page width and height (default: 1024)\n"
+        << "      --padding <px>        Padding around each glyph (default: 0)\n"
+        << "      --margin <px>         Space between glyphs and page border (default: 1)\n"
+        << "      --pages <n>           Maximum pages per atlas (default: 1)\n"
+        << "      --distance-range <f>  Distance mapping range (default: 0.5)\n"
+        << "      --field <type>        Distance field type: mtsdf, msdf, psdf, sdf (default: mtsdf)\n"
+        << "      --error-correction <m> MSDF error correction: edge-priority, disabled, edge-only, indiscriminate\n"
+        << "      --resolve             Resolve overlapping contours\n"
+        << "      --bitmap              Rasterize hinted 8-bit coverage instead of MTSDF (small UI sizes)\n"
+        << "      --subset              Also write <font>-subset with only the baked glyphs, hinting dropped\n"
+        << "      --subset-pin          Pin variable font axes to their defaults in the subset\n"
+        << "      --compress <fmt>      Block compress pages: none, bc4, bc5, bc7, auto (default: none)\n"
+        << "      --benchmark           Time msdfgen against the linear-segment kernel on resolved glyphs\n"
+        << "  -j, --threads <n>         Worker threads (default: all cores)\n";
+}
+
+static std::vector<std::string> Split(const std::string &value, char separator)
+{
+    std::vector<std::string> parts;
+    std::stringstream stream(value);
+    std::string part;
+    while (std::getline(stream, part, separator))
+    {
+        if (!part.empty())
+            parts.push_back(part);
+    }
+    return parts;
+}
+
+static bool ParseRanges(const std::string &value, std::vector<UnicodeRange> &ranges)
+{
+    for (auto &part : Split(value, ','))
+    {
+        auto bounds = Split(part, '-');
+        if (bounds.empty() || bounds.size() > 2)
+            return false;
+
+        UnicodeRange range;
+        range.start = static_cast<int32_t>(std::strtol(bounds[0].c_str(), nullptr, 16));
+        range.end = bounds.size() == 2 ? static_cast<int32_t>(std::strtol(bounds[1].c_str(), nullptr, 16)) : range.start;
+        if (range.end < range.start)
+            return false;
+        ranges.push_back(range);
+    }
+    return true;
+}
+
+static bool ParseFieldType(const std::string &value, int &field_type)
+{
+    static const char *names[] = {"mtsdf", "msdf", "psdf", "sdf"};
+    for (int i = 0; i < 4; i++)
+    {
+        if (value == names[i])
+        {
+            field_type = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseErrorCorrection(const std::string &value, int &error_correction)
+{
+    static const char *names[] = {"edge-priority", "disabled", "edge-only", "indiscriminate"};
+    for (int i = 0; i < 4; i++)
+    {
+        if (value == names[i])
+        {
+            error_correction = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseCompression(const std::string &value, int &compression)
+{
+    static const char *names[] = {"none", "bc4", "bc5", "bc7", "auto"};
+    for (int i = 0; i < 5; i++)
+    {
+        if (value == names[i])
+        {
+            compression = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ReadFile(const std::string &path, std::string &out)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::stringstream stream;
+    stream << file.rdbuf();
+    out = stream.str();
+    return true;
+}
+
+static std::string FileStem(const std::string &path)
+{
+    auto name = path.substr(path.find_last_of("/\\") + 1);
+    return name.substr(0, name.find_last_of('.'));
+}
+
+static std::string FileExtension(const std::string &path)
+{
+    auto name = path.substr(path.find_last_of("/\\") + 1);
+    auto dot = name.find_last_of('.');
+    return dot == std::string::npos ? "" : name.substr(dot);
+}
+
+int main(int argc, char **argv)
+{
+    std::string out_dir = ".";
+    std::string samples;
+    std::vector<UnicodeRange> ranges;
+    std::vector<int> glyph_sizes;
+    std::vector<std::string> font_paths;
+    AtlasConfig atlas_config;
+    atlas_config.flags = 0;
+    RenderConfig render_config;
+    int max_pages = 1;
+    int thread_count = 0;
+    bool subset = false;
+    bool benchmark = false;
+    int compression = AtlasCompression::Uncompressed;
+    const int auto_compression = 4;
+    int subset_flags = SubsetFlag::DropHinting;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << "\n";
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-o" || arg == "--out")
+            out_dir = next();
+        else if (arg == "-r" || arg == "--ranges")
+        {
+            if (!ParseRanges(next(), ranges))
+            {
+                std::cerr << "Invalid codepoint ranges\n";
+                return 1;
+            }
+        }
+        else if (arg == "-t" || arg == "--text")
+        {
+            auto path = next();
+            if (!ReadFile(path, samples))
+            {
+                std::cerr << "Failed to read " << path << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "-s" || arg == "--glyph-size")
+        {
+            for (auto &size : Split(next(), ','))
+                glyph_sizes.push_back(std::atoi(size.c_str()));
+        }
+        else if (arg == "--size")
+            atlas_config.size = std::atoi(next().c_str());
+        else if (arg == "--min-glyph-size")
+            atlas_config.min_glyph_size = std::atoi(next().c_str());
+        else if (arg == "--max-glyph-size")
+            atlas_config.max_glyph_size = std::atoi(next().c_str());
+        else if (arg == "--padding")
+            atlas_config.padding = std::atoi(next().c_str());
+        else if (arg == "--margin")
+            atlas_config.margin = std::atoi(next().c_str());
+        else if (arg == "--pages")
+            max_pages = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--distance-range")
+            render_config.distance_mapping_range = static_cast<float>(std::atof(next().c_str()));
+        else if (arg == "--field")
+        {
+            if (!ParseFieldType(next(), render_config.field_type))
+            {
+                std::cerr << "Invalid field type\n";
+                return 1;
+            }
+        }
+        else if (arg == "--error-correction")
+        {
+            if (!ParseErrorCorrection(next(), render_config.error_correction))
+            {
+                std::cerr << "Invalid error correction mode\n";
+                return 1;
+            }
+        }
+        else if (arg == "--resolve")
+            render_config.flags |= GlyphRenderFlag::ResolveIntersections;
+        else if (arg == "--bitmap")
+            render_config.flags |= GlyphRenderFlag::RasterizeBitmap;
+        else if (arg == "--compress")
+        {
+            if (!ParseCompression(next(), compression))
+            {
+                std::cerr << "Invalid compression format\n";
+                return 1;
+            }
+        }
+        else if (arg == "--subset")
+            subset = true;
+        else if (arg == "--benchmark")
+            benchmark = true;
+        else if (arg == "--subset-pin")
+            subset_flags |= SubsetFlag::PinVariations;
+        else if (arg == "-j" || arg == "--threads")
+            thread_count = std::atoi(next().c_str());
+        else if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage();
+            return 0;
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            PrintUsage();
+            return 1;
+        }
+        else
+            font_paths.push_back(arg);
+    }
+
+    if (font_paths.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (compression != AtlasCompression::Uncompressed && atlas_config.size % 4 != 0)
+    {
+        std::cerr << "--compress needs a --size that is a multiple of 4\n";
+        return 1;
+    }
+    if (ranges.empty() && samples.empty())
+        ranges.push_back(UnicodeRange{0x20, 0x7E});
+    if (glyph_sizes.empty())
+        glyph_sizes.push_back(atlas_config.glyph_size);
+
+    auto start_time = std::chrono::steady_clock::now();
+    Context ctx(nullptr, nullptr, nullptr);
+
+    // Font data has to outlive the faces
+    std::vector<std::string> font_data(font_paths.size());
+    std::vector<FontDescription> fonts;
+    fonts.reserve(font_paths.size());
+    for (size_t i = 0; i < font_paths.size(); i++)
+    {
+        if (!ReadFile(font_paths[i], font_data[i]))
+        {
+            std::cerr << "Failed to read " << font_paths[i] << "\n";
+            return 1;
+        }
+        Buffer<byte> data((void *)font_data[i].data(), static_cast<int32_t>(font_data[i].size()), Allocator::None);
+        fonts.emplace_back(ctx.ftLib, data);
+    }
+
+    std::vector<BakeVariant> variants;
+    for (size_t f = 0; f < fonts.size(); f++)
+    {
+        for (auto glyph_size : glyph_sizes)
+        {
+            BakeVariant variant;
+            variant.font = &fonts[f];
+            variant.atlas_config = atlas_config;
+            variant.atlas_config.glyph_size = glyph_size;
+            variant.render_config = render_config;
+            variant.max_pages = max_pages;
+            variant.compression = compression == auto_compression
+                                      ? DefaultCompression(AtlasBytesPerPixel(render_config))
+                                      : static_cast<AtlasCompression>(compression);
+            variant.output_path = out_dir + "/" + FileStem(font_paths[f]) + "-" + std::to_string(glyph_size) + ".fontatlas";
+            variants.push_back(std::move(variant));
+        }
+    }
+
+    // Glyph sets only depend on the font, the metrics and packing on every variant
+    std::vector<std::vector<int>> glyph_indices(fonts.size());
+    ParallelFor(static_cast<int>(fonts.size()), [&](int f)
+                { glyph_indices[f] = CollectGlyphIndices(&ctx, fonts[f].font_handle, ranges, samples); },
+                thread_count);
+    ParallelFor(static_cast<int>(variants.size()), [&](int v)
+                { PackBakeVariant(variants[v], glyph_indices[variants[v].font - fonts.data()]); },
+                thread_count);
+
+    if (subset)
+    {
+        for (size_t f = 0; f < fonts.size(); f++)
+        {
+            auto output_path = out_dir + "/" + FileStem(font_paths[f]) + "-subset" + FileExtension(font_paths[f]);
+            Buffer<byte> data((void *)font_data[f].data(), static_cast<int32_t>(font_data[f].size()), Allocator::None);
+            size_t size = WriteSubsetFont(data, ranges, samples, glyph_indices[f], subset_flags, output_path);
+            if (size == 0)
+            {
+                std::cerr << "Failed to subset " << font_paths[f] << "\n";
+                return 1;
+            }
+            std::cout << output_path << ": " << size << "/" << font_data[f].size() << " bytes\n";
+        }
+    }
+
+    if (benchmark)
+    {
+        for (auto &variant : variants)
+        {
+            auto timings = BenchmarkLinearField(variant);
+            std::cout << variant.output_path << ": " << timings.glyph_count << " resolved glyphs, msdfgen " << 1000.0 * timings.msdfgen_seconds
+                      << " ms, linear kernel " << 1000.0 * timings.kernel_seconds << " ms (" << timings.msdfgen_seconds / std::max(timings.kernel_seconds, 1e-9)
+                      << "x), max difference " << timings.max_error << " levels\n";
+        }
+    }
+
+    RenderBakeVariants(variants, thread_count);
+    for (auto &variant : variants)
+        CompressBakeVariant(variant, thread_count);
+
+    std::vector<char> written(variants.size());
+    ParallelFor(static_cast<int>(variants.size()), [&](int v)
+                { written[v] = WriteBakedAtlas(variants[v]); },
+                thread_count);
+
+    int result = 0;
+    for (size_t v = 0; v < variants.size(); v++)
+    {
+        auto &variant = variants[v];
+        if (!written[v])
+        {
+            std::cerr << "Failed to write " << variant.output_path << "\n";
+            result = 1;
+            continue;
+        }
+
+        int total = static_cast<int>(glyph_indices[variant.font - fonts.data()].size());
+        std::cout << variant.output_path << ": " << variant.packed_count << "/" << total << " glyphs, " << variant.page_count << " page(s)\n";
+        if (variant.compression != AtlasCompression::Uncompressed)
+            std::cout << "  compressed: rmse " << variant.report.rmse << ", psnr " << variant.report.psnr << " dB, max error " << variant.report.max_error << "\n";
+        if (variant.packed_count < total)
+            std::cerr << "Warning: " << (total - variant.packed_count) << " glyphs did not fit, increase --size or --pages\n";
+    }
+
+    for (auto &font : fonts)
+    {
+        font.font_handle->Dispose();
+        delete font.font_handle;
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    std::cout << "Baked " << variants.size() << " atlas(es) in " << elapsed << "s\n";
+    return result;
+}
@@ -0,0 +1,73 @@
+#include "api.h"
+#include <cstdio>
+
+static void PrintLog(const char *message)
+{
+    fputs(message, stderr);
+}
+
+static int Fail(const char *message)
+{
+    fprintf(stderr, "FAIL: %s\n", message);
+    return 1;
+}
+
+/// @brief Evicts a font's face before its metrics table is first built, the table must still cover every glyph
+/// @param argv Path of the test font
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        return Fail("usage: face_cache_test <font>");
+    const char *path = argv[1];
+
+    Context *ctx;
+    CreateContext(PrintLog, nullptr, nullptr, &ctx);
+
+    // Opened like LoadFontFromFile, without the FontDescription read that would reopen the face
+    auto font_handle = new FontHandle();
+    if (font_handle->OpenFile(ctx->ftLib, path, 0, &ctx->faceCache) != ReturnCode::Success)
+        return Fail("the font didn't load");
+    int units_per_em = font_handle->units_per_em;
+
+    int64_t bytes;
+    SetFaceCacheBudget(ctx, 1, &bytes);
+    if (font_handle->ft != nullptr)
+        return Fail("a one byte budget didn't evict the face");
+
+    int count = static_cast<int>(font_handle->GlyphCount());
+    if (count == 0)
+        return Fail("the glyph count depends on the face");
+
+    std::vector<GlyphMetrics> glyphs;
+    for (int i = 0; i < count; i++)
+        glyphs.emplace_back(i);
+    Buffer<GlyphMetrics> glyph_buffer(glyphs.data(), static_cast<int32_t>(glyphs.size() * sizeof(GlyphMetrics)), Allocator::None);
+    GetGlyphMetrics(ctx, font_handle, 32, 2, &glyph_buffer);
+
+    int boxes = 0;
+    for (auto &glyph : glyphs)
+        if (glyph.width_fu > 0 && glyph.height_fu > 0)
+            boxes++;
+    if (boxes == 0)
+        return Fail("every glyph came back with an empty box");
+    if (static_cast<int>(font_handle->MetricsTable().size()) != count)
+        return Fail("the metrics table doesn't cover every glyph");
+
+    // Reopening the face must leave the lock-free units per em alone
+    {
+        auto lock = font_handle->Lock();
+        if (font_handle->ft == nullptr)
+            return Fail("the face didn't reopen");
+    }
+    if (font_handle->units_per_em != units_per_em)
+        return Fail("units per em changed on reopen");
+
+    UnloadFont(ctx, font_handle);
+    SetFaceCacheBudget(ctx, 0, &bytes);
+    if (bytes != 0)
+        return Fail("FreeType memory is still charged to the unloaded font");
+
+    DestroyContext(ctx);
+    printf("face_cache: %d glyphs, %d with boxes\n", count, boxes);
+    return 0;
+}
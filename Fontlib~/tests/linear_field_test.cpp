@@ -0,0 +1,54 @@
+#include "bake.h"
+#include <cstdio>
+
+// Largest channel difference allowed between the linear kernel and msdfgen, in 8-bit levels
+static const float MAX_ERROR_LEVELS = 2.0f;
+
+static int Fail(const char *message)
+{
+    fprintf(stderr, "FAIL: %s\n", message);
+    return 1;
+}
+
+/// @brief Renders every resolved, all-linear glyph of the test font with msdfgen and with GenerateLinearField,
+/// the two fields must agree within MAX_ERROR_LEVELS
+/// @param argv Path of the test font
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        return Fail("usage: linear_field_test <font>");
+    const char *path = argv[1];
+
+    Context ctx(nullptr, nullptr, nullptr);
+    auto font_handle = new FontHandle();
+    if (font_handle->OpenFile(ctx.ftLib, path, 0, &ctx.faceCache) != ReturnCode::Success)
+        return Fail("the font didn't load");
+    FontDescription description(font_handle);
+
+    // Tiles the way fontlib-bake lays them out, the range spans the padding
+    BakeVariant variant;
+    variant.font = &description;
+    variant.atlas_config.padding = 4;
+    variant.atlas_config.flags = 0;
+    variant.render_config.distance_mapping_range = 4.0f / variant.atlas_config.glyph_size;
+    variant.render_config.flags = GlyphRenderFlag::ResolveIntersections;
+
+    int count = static_cast<int>(font_handle->GlyphCount());
+    for (int i = 0; i < count; i++)
+        variant.glyphs.emplace_back(i);
+    Buffer<GlyphMetrics> glyphs(variant.glyphs.data(), static_cast<int32_t>(variant.glyphs.size() * sizeof(GlyphMetrics)), Allocator::None);
+    GetRenderGlyphMetrics(glyphs, font_handle, variant.atlas_config, variant.render_config);
+
+    LinearFieldBenchmark result = BenchmarkLinearField(variant);
+    if (result.glyph_count == 0)
+        return Fail("no glyph went through the linear kernel");
+    if (result.max_error > MAX_ERROR_LEVELS)
+    {
+        fprintf(stderr, "FAIL: the linear kernel is %g levels off msdfgen\n", result.max_error);
+        return 1;
+    }
+
+    ctx.UnloadFont(font_handle);
+    printf("linear_field: %d glyphs, max difference %g levels\n", result.glyph_count, result.max_error);
+    return 0;
+}
@@ -1,6 +1,7 @@
 using System;
 using System.Collections.Generic;
 using System.Text;
+using Elfenlabs.Collections;
 using Unity.Collections;
 
 namespace Elfenlabs.Text
@@ -45,6 +46,30 @@ namespace Elfenlabs.Text
             }
         }
 
+        /// <summary>
+        /// Merges the collected codepoints into sorted, non-overlapping ranges for <see cref="FontLibrary.PrewarmCharset"/>.
+        /// Ligatures don't need to be listed, the native side collects them through the font's GSUB closure.
+        /// </summary>
+        public NativeBuffer<UnicodeRange> ToRanges(Allocator allocator)
+        {
+            var codes = new List<int>(Codes);
+            codes.Sort();
+
+            var ranges = new List<UnicodeRange>();
+            foreach (var code in codes)
+            {
+                if (ranges.Count > 0 && ranges[^1].End + 1 == code)
+                    ranges[^1] = new UnicodeRange(ranges[^1].Start, code);
+                else
+                    ranges.Add(new UnicodeRange(code, code));
+            }
+
+            var buffer = new NativeBuffer<UnicodeRange>(ranges.Count, allocator);
+            for (int i = 0; i < ranges.Count; i++)
+                buffer[i] = ranges[i];
+            return buffer;
+        }
+
         public override string ToString()
         {
             var builder = new System.Text.StringBuilder();
@@ -0,0 +1,121 @@
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using Unity.Collections.LowLevel.Unsafe;
+using UnityEngine;
+
+namespace Elfenlabs.Text
+{
+    /// <summary>
+    /// Header of a .fontatlas file written by the offline fontlib-bake tool.
+    /// Followed by GlyphCount glyph metrics and PageCount pages of Size * Size pixels, or of 4x4 blocks when compressed.
+    /// </summary>
+    [Serializable]
+    [StructLayout(LayoutKind.Sequential)]
+    public struct BakedAtlasHeader
+    {
+        public int Magic;
+        public int Version;
+        public AtlasConfig AtlasConfig;
+        public RenderConfig RenderConfig;
+        public int UnitsPerEM;
+        public int Ascender;
+        public int Descender;
+        public int Height;
+        public int GlyphCount;
+        public int PageCount;
+        public int BytesPerPixel;
+        public AtlasCompression Compression;
+    }
+
+    public static class BakedFontAtlas
+    {
+        public const int Version = 4;
+
+        // "FLBA" read as a little endian int
+        const int Magic = 'F' | 'L' << 8 | 'B' << 16 | 'A' << 24;
+
+        /// <summary>
+        /// Loads a baked atlas file into a glyph table and a texture array with one slice per atlas page.
+        /// </summary>
+        /// <param name="bytes">Contents of the .fontatlas file.</param>
+        /// <param name="glyphs">Receives the packed glyph metrics.</param>
+        /// <param name="textureArray">Receives the atlas pages.</param>
+        /// <returns>The file header.</returns>
+        public static unsafe BakedAtlasHeader Load(byte[] bytes, List<GlyphMetrics> glyphs, out Texture2DArray textureArray)
+        {
+            var headerSize = UnsafeUtility.SizeOf<BakedAtlasHeader>();
+            var glyphSize = UnsafeUtility.SizeOf<GlyphMetrics>();
+            if (bytes.Length < headerSize)
+                throw new ArgumentException("File is too small to be a baked font atlas.");
+
+            fixed (byte* ptr = bytes)
+            {
+                UnsafeUtility.CopyPtrToStructure<BakedAtlasHeader>(ptr, out var header);
+                if (header.Magic != Magic || header.Version != Version)
+                    throw new ArgumentException($"Unsupported baked font atlas (version {header.Version}).");
+
+                var size = header.AtlasConfig.Size;
+                var pageBytes = header.Compression == AtlasCompression.Uncompressed
+                    ? size * size * header.BytesPerPixel
+                    : (size / 4) * (size / 4) * (header.Compression == AtlasCompression.BC4 ? 8 : 16);
+                var expectedLength = headerSize + (long)header.GlyphCount * glyphSize + (long)header.PageCount * pageBytes;
+                if (bytes.Length < expectedLength)
+                    throw new ArgumentException("Baked font atlas is truncated.");
+
+                var glyphPtr = ptr + headerSize;
+                glyphs.Clear();
+                glyphs.Capacity = Math.Max(glyphs.Capacity, header.GlyphCount);
+                for (int i = 0; i < header.GlyphCount; i++)
+                {
+                    UnsafeUtility.CopyPtrToStructure<GlyphMetrics>(glyphPtr + i * glyphSize, out var glyph);
+                    glyphs.Add(glyph);
+                }
+
+                textureArray = new Texture2DArray(size, size, Math.Max(1, header.PageCount), GetTextureFormat(header.BytesPerPixel, header.Compression), false)
+                {
+                    name = "FontAtlas"
+                };
+
+                var pagePtr = glyphPtr + header.GlyphCount * glyphSize;
+                for (int page = 0; page < header.PageCount; page++)
+                {
+                    var pixels = textureArray.GetPixelData<byte>(0, page);
+                    UnsafeUtility.MemCpy(pixels.GetUnsafePtr(), pagePtr + (long)page * pageBytes, pageBytes);
+                }
+                textureArray.Apply();
+
+                return header;
+            }
+        }
+
+        /// <summary>
+        /// Texture format of an atlas page with the given number of bytes per pixel and compression.
+        /// </summary>
+        public static TextureFormat GetTextureFormat(int bytesPerPixel, AtlasCompression compression)
+        {
+            return compression switch
+            {
+                AtlasCompression.Uncompressed => GetTextureFormat(bytesPerPixel),
+                AtlasCompression.BC4 => TextureFormat.BC4,
+                AtlasCompression.BC5 => TextureFormat.BC5,
+                AtlasCompression.BC7 => TextureFormat.BC7,
+                _ => throw new ArgumentException($"Unsupported atlas compression {compression}."),
+            };
+        }
+
+        /// <summary>
+        /// Texture format of an atlas page with the given number of bytes per pixel.
+        /// </summary>
+        public static TextureFormat GetTextureFormat(int bytesPerPixel)
+        {
+            return bytesPerPixel switch
+            {
+                1 => TextureFormat.R8,
+                3 => TextureFormat.RGB24,
+                4 => TextureFormat.RGBA32,
+                _ => throw new ArgumentException($"Unsupported atlas pixel size {bytesPerPixel}."),
+            };
+        }
+    }
+}
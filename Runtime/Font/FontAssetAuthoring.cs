@@ -15,6 +15,12 @@ namespace Elfenlabs.Text
         [Header("Font")]
         public Font Font;
 
+        [Tooltip("Path of the font file relative to StreamingAssets. When set, the font is memory-mapped at runtime instead of embedded in the asset.")]
+        public string StreamingFontPath;
+
+        [Tooltip("Face index for TrueType collections (.ttc), 0 for single fonts.")]
+        public int FaceIndex;
+
         [Header("Atlas Settings")]
         public AtlasConfig AtlasConfig;
         public RenderConfig RenderConfig;
@@ -50,11 +56,20 @@ namespace Elfenlabs.Text
             }
             root.FlattenedGlyphMap.Flatten(builder, map);
 
-            // root.FontBytes
-            var fontPath = AssetDatabase.GetAssetPath(Font);
-            var fontData = System.IO.File.ReadAllBytes(fontPath);
-            var fontBytesBuffer = builder.Allocate(ref root.FontBytes, fontData.Length);
-            unsafe { Elfenlabs.Unsafe.UnsafeUtility.CopyArrayToPtr(fontData, fontBytesBuffer.GetUnsafePtr(), fontData.Length); }
+            // root.FontBytes, or root.FontFilePath for streamed fonts
+            if (string.IsNullOrEmpty(StreamingFontPath))
+            {
+                var fontPath = AssetDatabase.GetAssetPath(Font);
+                var fontData = System.IO.File.ReadAllBytes(fontPath);
+                var fontBytesBuffer = builder.Allocate(ref root.FontBytes, fontData.Length);
+                unsafe { Elfenlabs.Unsafe.UnsafeUtility.CopyArrayToPtr(fontData, fontBytesBuffer.GetUnsafePtr(), fontData.Length); }
+            }
+            else
+            {
+                builder.Allocate(ref root.FontBytes, 0);
+                builder.AllocateString(ref root.FontFilePath, StreamingFontPath);
+            }
+            root.FaceIndex = FaceIndex;
 
             // root.SerializedAtlasPacker
             var unpacked = BlobUtility.FromBytes<AtlasPacker<GlyphMetrics>, AtlasPacker<GlyphMetrics>.Blob>(AtlasBlobBytes, Allocator.Temp);
@@ -32,8 +32,10 @@ namespace Elfenlabs.Text
                 return;
             }
 
-            // self.CompactFlags = (AtlasCompactFlags)EditorGUILayout.EnumFlagsField("Compact Flags", self.CompactFlags);
+            self.AtlasConfig.Flags = (int)(AtlasCompactFlags)EditorGUILayout.EnumFlagsField("Compact Flags", (AtlasCompactFlags)self.AtlasConfig.Flags);
             self.RenderConfig.Flags = (GlyphRenderFlags)EditorGUILayout.EnumFlagsField("Glyph Render Flags", self.RenderConfig.Flags);
+            self.RenderConfig.FieldType = (GlyphFieldType)EditorGUILayout.EnumPopup("Field Type", self.RenderConfig.FieldType);
+            self.RenderConfig.ErrorCorrection = (GlyphErrorCorrection)EditorGUILayout.EnumPopup("Error Correction", self.RenderConfig.ErrorCorrection);
 
             if (GUILayout.Button("Shape Test"))
             {
@@ -103,7 +105,7 @@ namespace Elfenlabs.Text
             // Generate atlas texture
             var textureArray = self.TextureArray;
             var fontDescription = LoadFont();
-            var textureBuffer = NativeBuffer<Color32>.Alias(textureArray.GetPixelData<Color32>(0, 0));
+            var textureBuffer = NativeBuffer<byte>.Alias(textureArray.GetPixelData<byte>(0, 0));
 
             // Prepare character set for generation
             var glyphs = PrepareGlyphBuffer(Allocator.Temp);
@@ -115,13 +117,6 @@ namespace Elfenlabs.Text
                     Margin = self.AtlasConfig.Margin
                 }, Allocator.Persistent);
 
-            FontLibrary.GetGlyphMetrics(
-                libCtx,
-                fontDescription.Handle,
-                self.AtlasConfig.GlyphSize,
-                self.AtlasConfig.Padding,
-                ref glyphs);
-
             var packedCount = atlas.PackGlyphs(glyphs.AsNativeArray());
 
             var remaining = glyphs.Count() - packedCount;
@@ -152,6 +147,15 @@ namespace Elfenlabs.Text
                 AssetDatabase.AddObjectToAsset(self.Material, self);
             }
             self.Material.SetTexture("_MainTex", textureArray);
+            var isSingleChannelField = !IsBitmap && self.RenderConfig.BytesPerPixel == 1;
+            if (IsBitmap)
+                self.Material.EnableKeyword("_GLYPH_BITMAP");
+            else
+                self.Material.DisableKeyword("_GLYPH_BITMAP");
+            if (isSingleChannelField)
+                self.Material.EnableKeyword("_GLYPH_SDF");
+            else
+                self.Material.DisableKeyword("_GLYPH_SDF");
 
             EditorUtility.SetDirty(target);
             AssetDatabase.SaveAssets();
@@ -180,11 +184,13 @@ namespace Elfenlabs.Text
                 self.AtlasBlobBytes = new byte[0];
             }
 
-            var textureArray = new Texture2DArray(self.AtlasConfig.Size, self.AtlasConfig.Size, 1, TextureFormat.RGBA32, false);
-            var rawColors = textureArray.GetPixelData<Color32>(0, 0);
-            for (var i = 0; i < rawColors.Length; i++)
+            // Bitmaps and single-channel fields use R8, MSDF RGB24 and MTSDF RGBA32
+            var format = BakedFontAtlas.GetTextureFormat(self.RenderConfig.BytesPerPixel);
+            var textureArray = new Texture2DArray(self.AtlasConfig.Size, self.AtlasConfig.Size, 1, format, false);
+            var rawBytes = textureArray.GetPixelData<byte>(0, 0);
+            for (var i = 0; i < rawBytes.Length; i++)
             {
-                rawColors[i] = new Color32(0, 0, 0, 0);
+                rawBytes[i] = 0;
             }
             textureArray.name = "FontAtlas";
             textureArray.Apply();
@@ -195,6 +201,8 @@ namespace Elfenlabs.Text
             AssetDatabase.SaveAssets();
         }
 
+        bool IsBitmap => (self.RenderConfig.Flags & GlyphRenderFlags.RasterizeBitmap) != 0;
+
         NativeBuffer<GlyphMetrics> PrepareGlyphBuffer(Allocator allocator)
         {
             var fontDescription = LoadFont();
@@ -207,32 +215,24 @@ namespace Elfenlabs.Text
                 charsetBuilder.Add(self.UnicodeSamples[i]);
             for (int i = 0; i < self.Ligatures.Count; i++)
                 charsetBuilder.Add(self.Ligatures[i]);
-            var str = charsetBuilder.ToString();
-            var strBuffer = NativeBuffer<byte>.FromString(str, Allocator.Temp);
-
-            FontLibrary.ShapeText(libCtx, fontDescription.Handle, Allocator.Temp, strBuffer, out var glyphShapeResult);
-
-            var glyphSet = new NativeHashSet<int>(glyphShapeResult.Count(), Allocator.Temp);
-
-            for (int i = 0; i < glyphShapeResult.Count(); i++)
-            {
-                glyphSet.Add(glyphShapeResult[i].CodePoint);
-            }
+            var ranges = charsetBuilder.ToRanges(Allocator.Temp);
 
-            var index = 0;
-            var glyphs = new NativeBuffer<GlyphMetrics>(glyphSet.Count, allocator);
-            foreach (var glyphCodePoint in glyphSet)
-            {
-                glyphs[index] = new GlyphMetrics { CodePoint = glyphCodePoint };
-                index++;
-            }
+            // Map the codepoints through the cmap, ligatures and alternates come from the GSUB closure
+            FontLibrary.PrewarmCharset(
+                libCtx,
+                fontDescription.Handle,
+                self.AtlasConfig,
+                self.RenderConfig,
+                in ranges,
+                CharsetFlags.SubstituteClosure,
+                allocator,
+                out var glyphs);
 
-            strBuffer.Dispose();
-            glyphShapeResult.Dispose();
-            glyphSet.Dispose();
+            ranges.Dispose();
 
             return glyphs;
         }
+
         FontDescription LoadFont()
         {
             var font = self.Font;
@@ -25,6 +25,8 @@ namespace Elfenlabs.Text
     {
         public BlobFlattenedHashMap<int, GlyphRuntimeData> FlattenedGlyphMap;
         public BlobArray<byte> FontBytes;
+        public BlobString FontFilePath; // Relative to StreamingAssets, the font is memory-mapped instead of embedded when set
+        public int FaceIndex;
         public AtlasPacker<GlyphMetrics>.Blob SerializedAtlasPacker;
         public AtlasConfig AtlasConfig;
         public RenderConfig RenderConfig;
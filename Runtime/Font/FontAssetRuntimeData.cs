@@ -1,5 +1,4 @@
 using System;
-using Elfenlabs.Texture;
 using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
 using Unity.Entities;
@@ -19,7 +18,8 @@ namespace Elfenlabs.Text
         [NativeDisableContainerSafetyRestriction]
         public UnsafeParallelHashSet<int> MissingGlyphSet;
 
-        public AtlasPacker<GlyphMetrics> Atlas;
+        // Native GlyphAtlas over the pages of the material's texture, evicts and compacts when full
+        public IntPtr DynamicAtlas;
         public BatchMaterialID MaterialID;
 
         public readonly bool Equals(FontAssetRuntimeData other)
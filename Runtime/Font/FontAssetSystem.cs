@@ -105,35 +105,71 @@ namespace Elfenlabs.Text
 
         FontAssetRuntimeData CreateAssetRuntime(ref SystemState state, EntityCommandBuffer ecb, IntPtr pluginHandle, FontAssetReference assetRef)
         {
-            FontLibrary.LoadFont(
-                        pluginHandle,
-                        assetRef.Value.Value.FontBytes.AsNativeBuffer(),
-                        out var fontDesc);
+            FontDescription fontDesc;
+            ref var assetData = ref assetRef.Value.Value;
+            if (assetData.FontFilePath.Length > 0)
+            {
+                // Memory-mapped, resident memory follows the glyphs in use instead of the file size
+                var path = System.IO.Path.Combine(Application.streamingAssetsPath, assetData.FontFilePath.ToString());
+                var result = FontLibrary.LoadFontFromFile(pluginHandle, path, assetData.FaceIndex, out fontDesc);
+                if (result != ReturnCode.Success)
+                    Debug.LogError($"Failed to load font file {path}: {result}");
+            }
+            else
+            {
+                FontLibrary.LoadFont(
+                            pluginHandle,
+                            assetData.FontBytes.AsNativeBuffer(),
+                            out fontDesc);
+            }
 
-            var atlas = assetRef.Value.Value.SerializedAtlasPacker.Deserialize(Allocator.Persistent);
+            var glyphMap = assetRef.Value.Value.FlattenedGlyphMap.Reconstruct(Allocator.Persistent);
+            var prototype = AdaptPrefab(ref state, ecb, quadPrototype, assetRef.Value.Value.Material, out var batchMaterialID, out var texture);
 
             return new FontAssetRuntimeData
             {
                 AssetReference = assetRef.Value,
                 Description = fontDesc,
-                GlyphMap = assetRef.Value.Value.FlattenedGlyphMap.Reconstruct(Allocator.Persistent),
-                PrototypeEntity = AdaptPrefab(ref state, ecb, quadPrototype, assetRef.Value.Value.Material, out var batchMaterialID),
-                Atlas = atlas,
+                GlyphMap = glyphMap,
+                PrototypeEntity = prototype,
+                DynamicAtlas = CreateDynamicAtlas(pluginHandle, ref assetData, texture, glyphMap),
                 MissingGlyphSet = new UnsafeParallelHashSet<int>(32, Allocator.Persistent),
                 MaterialID = batchMaterialID,
             };
         }
 
+        /// <summary>
+        /// Creates the native atlas that places missing glyphs at runtime, seeded with the baked glyphs so they are
+        /// evicted and compacted like the ones added later.
+        /// </summary>
+        static IntPtr CreateDynamicAtlas(IntPtr pluginHandle, ref FontAssetData assetData, Texture2DArray texture, UnsafeParallelHashMap<int, GlyphRuntimeData> glyphMap)
+        {
+            FontLibrary.CreateGlyphAtlas(pluginHandle, assetData.AtlasConfig, assetData.RenderConfig, texture.depth, out var atlas);
+
+            // Compaction moves tiles within the CPU copy of the pages
+            for (int page = 0; page < texture.depth; page++)
+                FontLibrary.SetGlyphAtlasPage(pluginHandle, atlas, page, NativeBuffer<byte>.Alias(texture.GetPixelData<byte>(0, page)));
+
+            var bakedGlyphs = new NativeBuffer<GlyphMetrics>(glyphMap.Count(), Allocator.Temp);
+            var i = 0;
+            foreach (var pair in glyphMap)
+                bakedGlyphs[i++] = pair.Value.Metrics;
+            FontLibrary.RegisterAtlasGlyphs(pluginHandle, atlas, 0, in bakedGlyphs, Time.frameCount);
+            bakedGlyphs.Dispose();
+            return atlas;
+        }
+
         void DisposeAssetRuntime(ref SystemState state, EntityCommandBuffer ecb, FontAssetRuntimeData runtimeData)
         {
             runtimeData.GlyphMap.Dispose();
             runtimeData.MissingGlyphSet.Dispose();
             ecb.DestroyEntity(runtimeData.PrototypeEntity);
             var pluginHandle = SystemAPI.GetSingleton<FontPluginRuntimeHandle>().Value;
+            FontLibrary.DestroyGlyphAtlas(pluginHandle, runtimeData.DynamicAtlas);
             FontLibrary.UnloadFont(pluginHandle, runtimeData.Description.Handle);
         }
 
-        readonly Entity AdaptPrefab(ref SystemState state, EntityCommandBuffer ecb, Entity original, UnityObjectRef<Material> material, out BatchMaterialID batchMaterialID)
+        readonly Entity AdaptPrefab(ref SystemState state, EntityCommandBuffer ecb, Entity original, UnityObjectRef<Material> material, out BatchMaterialID batchMaterialID, out Texture2DArray texture)
         {
             var prototype = ecb.Instantiate(original);
 
@@ -156,6 +192,7 @@ namespace Elfenlabs.Text
             {
                 mainTexture = textureClone
             };
+            texture = textureClone;
 
             // Register the cloned material
             batchMaterialID = RenderUtility.RegisterMaterial(state.World, materialClone);
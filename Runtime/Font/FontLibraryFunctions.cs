@@ -9,6 +9,8 @@ namespace Elfenlabs.Text
 {
     /// <summary>
     /// Provides bindings to native font library functions for text rendering and font management.
+    /// Only the per-text shaping functions have Into variants that fill caller-owned buffers. Other functions that
+    /// return a <see cref="NativeBuffer{T}"/> allocate it with the given allocator, and the caller disposes it.
     /// </summary>
     public static class FontLibrary
     {
@@ -88,6 +90,38 @@ namespace Elfenlabs.Text
             out FontDescription fontDescription
         );
 
+        /// <summary>
+        /// Loads a font from a file path. The file is memory-mapped, so only the tables that are used become resident.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="path">UTF-8 path of the font file.</param>
+        /// <param name="faceIndex">Face index for TrueType collections (.ttc), 0 for single fonts.</param>
+        /// <param name="fontDescription">Output parameter that receives information about the loaded font.</param>
+        /// <returns>FontNotFound if the file can't be opened, Failure if it isn't a font or the face doesn't exist.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode LoadFontFromFile(
+            IntPtr ctx,
+            NativeBuffer<byte> path,
+            int faceIndex,
+            out FontDescription fontDescription
+        );
+
+        /// <summary>
+        /// Loads a font from a file path. The file is memory-mapped, so only the tables that are used become resident.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="path">Path of the font file.</param>
+        /// <param name="faceIndex">Face index for TrueType collections (.ttc), 0 for single fonts.</param>
+        /// <param name="fontDescription">Output parameter that receives information about the loaded font.</param>
+        /// <returns>FontNotFound if the file can't be opened, Failure if it isn't a font or the face doesn't exist.</returns>
+        public static ReturnCode LoadFontFromFile(IntPtr ctx, string path, int faceIndex, out FontDescription fontDescription)
+        {
+            var pathBuffer = NativeBuffer<byte>.FromString(path, Allocator.Temp);
+            var result = LoadFontFromFile(ctx, pathBuffer, faceIndex, out fontDescription);
+            pathBuffer.Dispose();
+            return result;
+        }
+
         /// <summary>
         /// Unloads a previously loaded font and releases associated resources.
         /// </summary>
@@ -118,6 +152,134 @@ namespace Elfenlabs.Text
             out NativeBuffer<ShapingGlyph> outGlyphs
         );
 
+        /// <summary>
+        /// Shapes text into a caller-owned buffer without going through the allocation callback.
+        /// Pass an empty buffer to query the required count first; the shaping result is cached per thread,
+        /// so the following call with the same text doesn't shape again.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="text">UTF-8 text.</param>
+        /// <param name="glyphs">Destination buffer.</param>
+        /// <param name="count">Number of shaped glyphs, also set when the buffer is too small.</param>
+        /// <returns><see cref="ReturnCode.ShapingOutTooSmall"/> if the buffer can't hold all glyphs.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode ShapeTextInto(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            in NativeBuffer<byte> text,
+            ref NativeBuffer<ShapingGlyph> glyphs,
+            out int count);
+
+        /// <summary>
+        /// Shapes text into structure-of-arrays streams with positions already scaled to em, ready for Burst.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="allocator">Allocator for the stream buffers.</param>
+        /// <param name="text">UTF-8 text.</param>
+        /// <param name="streams">Streams to produce.</param>
+        /// <param name="outStreams">Shaped glyph streams, dispose after use.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode ShapeTextStreams(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            Allocator allocator,
+            in NativeBuffer<byte> text,
+            ShapeStreams streams,
+            out ShapedGlyphStreams outStreams);
+
+        /// <summary>
+        /// Shapes text into caller-owned streams without going through the allocation callback.
+        /// <see cref="ShapedGlyphStreams.Streams"/> selects the streams to fill and <see cref="ShapedGlyphStreams.Count"/>
+        /// receives the number of shaped glyphs, also when a stream is too small.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="text">UTF-8 text.</param>
+        /// <param name="streams">Destination streams.</param>
+        /// <returns><see cref="ReturnCode.ShapingOutTooSmall"/> if a requested stream can't hold all glyphs.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode ShapeTextStreamsInto(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            in NativeBuffer<byte> text,
+            ref ShapedGlyphStreams streams);
+
+        /// <summary>
+        /// Shapes text like <see cref="ShapeText"/> and builds its cluster map, which answers caret and hit test
+        /// queries in O(log n) instead of walking the glyphs.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="allocator">Allocator for the glyph buffer.</param>
+        /// <param name="text">UTF-8 text.</param>
+        /// <param name="glyphs">Shaped glyphs.</param>
+        /// <param name="clusterMap">Cluster map with lines broken after newlines, destroy with <see cref="DestroyClusterMap"/>.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode ShapeTextWithClusterMap(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            Allocator allocator,
+            in NativeBuffer<byte> text,
+            out NativeBuffer<ShapingGlyph> glyphs,
+            out IntPtr clusterMap);
+
+        /// <summary>
+        /// Destroys a cluster map.
+        /// </summary>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode DestroyClusterMap(IntPtr ctx, IntPtr clusterMap);
+
+        /// <summary>
+        /// Sets the lines of a cluster map after wrapping and recomputes its pen positions.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="clusterMap">Cluster map.</param>
+        /// <param name="lineStarts">First glyph of every line after the first in ascending order, empty to break after newlines only.</param>
+        /// <returns><see cref="ReturnCode.InvalidArgument"/> if the line starts aren't ascending.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode SetClusterMapLines(
+            IntPtr ctx,
+            IntPtr clusterMap,
+            in NativeBuffer<int> lineStarts);
+
+        /// <summary>
+        /// Finds the caret of a byte offset. Carets inside a ligature split its advance evenly.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="clusterMap">Cluster map.</param>
+        /// <param name="byteOffset">Byte offset into the shaped text.</param>
+        /// <param name="caret">Pen x and line of the caret, and the glyphs of its cluster.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode GetCaretPosition(
+            IntPtr ctx,
+            IntPtr clusterMap,
+            int byteOffset,
+            out CaretPosition caret);
+
+        /// <summary>
+        /// Finds the caret stop nearest to a point of the laid-out text.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="clusterMap">Cluster map.</param>
+        /// <param name="xEm">Pen x from the start of the line.</param>
+        /// <param name="yEm">Distance from the top of the first line, growing downwards.</param>
+        /// <param name="lineHeightEm">Line height.</param>
+        /// <param name="byteOffset">Byte offset of the caret stop.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode HitTestClusterMap(
+            IntPtr ctx,
+            IntPtr clusterMap,
+            float xEm,
+            float yEm,
+            float lineHeightEm,
+            out int byteOffset);
+
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern ReturnCode GetGlyphMetrics(
             IntPtr ctx,
@@ -127,6 +289,53 @@ namespace Elfenlabs.Text
             ref NativeBuffer<GlyphMetrics> refGlyphs
         );
 
+        /// <summary>
+        /// Reads the unscaled box and advances of many glyphs at once. The font builds its metrics table on first use
+        /// from hmtx/vmtx and the glyf or CFF bounds, later calls are plain lookups.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="glyphs">Glyph indices.</param>
+        /// <param name="metrics">One entry per glyph index, glyphs outside the font get zero metrics.</param>
+        /// <returns>InvalidArgument if <paramref name="metrics"/> is smaller than <paramref name="glyphs"/>.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode GetGlyphTableMetrics(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            in NativeBuffer<int> glyphs,
+            ref NativeBuffer<GlyphTableMetrics> metrics);
+
+        /// <summary>
+        /// Fills the glyph metrics for the given atlas and render configuration.
+        /// Uses hinted pixel metrics when <see cref="GlyphRenderFlags.RasterizeBitmap"/> is set.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="atlasConfig">Atlas configuration.</param>
+        /// <param name="renderConfig">Render configuration.</param>
+        /// <param name="refGlyphs">Glyphs with their index set, receives the metrics.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode GetGlyphAtlasMetrics(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            AtlasConfig atlasConfig,
+            RenderConfig renderConfig,
+            ref NativeBuffer<GlyphMetrics> refGlyphs
+        );
+
+        /// <summary>
+        /// Renders glyphs into an atlas page on the calling thread. Glyphs with AtlasPage -1 or an empty tile are skipped.
+        /// <see cref="EnqueueGlyphRenders"/> renders on the library's background workers, and fontlib-bake renders
+        /// offline charsets on all cores.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="atlasConfig">Atlas configuration.</param>
+        /// <param name="renderConfig">Render configuration.</param>
+        /// <param name="glyphs">Packed glyphs to render.</param>
+        /// <param name="texture">Raw pixel data of the atlas page with <see cref="RenderConfig.BytesPerPixel"/> bytes per pixel.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern ReturnCode RenderGlyphsToAtlas(
             IntPtr ctx,
@@ -134,7 +343,307 @@ namespace Elfenlabs.Text
             AtlasConfig atlasConfig,
             RenderConfig renderConfig,
             in NativeBuffer<GlyphMetrics> glyphs,
-            ref NativeBuffer<Color32> texture);
+            ref NativeBuffer<byte> texture);
+
+        /// <summary>
+        /// Collects the glyphs of codepoint ranges straight from the font's cmap and fills their atlas metrics.
+        /// The glyphs can then be packed and rendered with <see cref="RenderGlyphsToAtlas"/> or <see cref="EnqueueGlyphRenders"/>.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="atlasConfig">Atlas configuration.</param>
+        /// <param name="renderConfig">Render configuration.</param>
+        /// <param name="ranges">Inclusive codepoint ranges.</param>
+        /// <param name="flags">Charset flags.</param>
+        /// <param name="allocator">Allocator for the output buffer.</param>
+        /// <param name="glyphs">Unique glyphs in ascending index order with their metrics set.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode PrewarmCharset(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            AtlasConfig atlasConfig,
+            RenderConfig renderConfig,
+            in NativeBuffer<UnicodeRange> ranges,
+            CharsetFlags flags,
+            Allocator allocator,
+            out NativeBuffer<GlyphMetrics> glyphs);
+
+        /// <summary>
+        /// Block compresses a rendered atlas page.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="atlasConfig">Atlas configuration, the size has to be a multiple of 4.</param>
+        /// <param name="renderConfig">Render configuration, decides the bytes per pixel of the page.</param>
+        /// <param name="compression">BC4 for single channel pages, BC7 for MSDF and MTSDF.</param>
+        /// <param name="page">Uncompressed page.</param>
+        /// <param name="compressed">Receives the compressed blocks, (Size / 4)² blocks of 8 (BC4) or 16 bytes.</param>
+        /// <param name="report">Error against the uncompressed page.</param>
+        /// <returns>InvalidArgument if the page size isn't a multiple of 4 or a buffer is too small.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode CompressAtlasPage(
+            IntPtr ctx,
+            AtlasConfig atlasConfig,
+            RenderConfig renderConfig,
+            AtlasCompression compression,
+            in NativeBuffer<byte> page,
+            ref NativeBuffer<byte> compressed,
+            out CompressionReport report);
+
+        /// <summary>
+        /// Re-encodes only the blocks under the tiles of the given glyphs, e.g. after <see cref="PollCompletedGlyphs"/>.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="atlasConfig">Atlas configuration.</param>
+        /// <param name="renderConfig">Render configuration.</param>
+        /// <param name="compression">Compression the page was encoded with.</param>
+        /// <param name="glyphs">Glyphs on this page whose tiles changed.</param>
+        /// <param name="page">Uncompressed page.</param>
+        /// <param name="compressed">Compressed page to update.</param>
+        /// <returns>InvalidArgument if the page size isn't a multiple of 4 or a buffer is too small.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode CompressAtlasGlyphs(
+            IntPtr ctx,
+            AtlasConfig atlasConfig,
+            RenderConfig renderConfig,
+            AtlasCompression compression,
+            in NativeBuffer<GlyphMetrics> glyphs,
+            in NativeBuffer<byte> page,
+            ref NativeBuffer<byte> compressed);
+
+        /// <summary>
+        /// Builds a minimal font that only holds the glyphs of a charset. Ligatures and alternates are kept through the GSUB closure.
+        /// Load the result with <see cref="LoadFont"/> to cut download size, load time and runtime memory.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontData">Font file.</param>
+        /// <param name="faceIndex">Face index for TrueType collections (.ttc), 0 for single fonts.</param>
+        /// <param name="ranges">Inclusive codepoint ranges to keep.</param>
+        /// <param name="flags">Subset flags.</param>
+        /// <param name="allocator">Allocator for the output buffer.</param>
+        /// <param name="subsetFontData">The subset font file.</param>
+        /// <returns>Failure if the font can't be subset.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode SubsetFont(
+            IntPtr ctx,
+            NativeBuffer<byte> fontData,
+            int faceIndex,
+            in NativeBuffer<UnicodeRange> ranges,
+            SubsetFlags flags,
+            Allocator allocator,
+            out NativeBuffer<byte> subsetFontData);
+
+        /// <summary>
+        /// <see cref="PrewarmCharset"/> into a caller-owned buffer, pass an empty buffer to query the required count first.
+        /// </summary>
+        /// <returns><see cref="ReturnCode.ShapingOutTooSmall"/> if the buffer can't hold all glyphs.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode PrewarmCharsetInto(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            AtlasConfig atlasConfig,
+            RenderConfig renderConfig,
+            in NativeBuffer<UnicodeRange> ranges,
+            CharsetFlags flags,
+            ref NativeBuffer<GlyphMetrics> glyphs,
+            out int count);
+
+        /// <summary>
+        /// Creates a dynamic glyph atlas that evicts the least recently used glyphs and compacts its pages when full.
+        /// Several fonts can share the atlas, e.g. the styles of a family so mixed-style text renders with one material.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="atlasConfig">Atlas configuration, <see cref="AtlasConfig.Flags"/> selects the <see cref="AtlasCompactFlags"/>.</param>
+        /// <param name="renderConfig">Render configuration, decides the bytes per pixel.</param>
+        /// <param name="maxPages">Maximum number of atlas pages.</param>
+        /// <param name="atlas">Output parameter that receives the atlas pointer.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode CreateGlyphAtlas(
+            IntPtr ctx,
+            AtlasConfig atlasConfig,
+            RenderConfig renderConfig,
+            int maxPages,
+            out IntPtr atlas);
+
+        /// <summary>
+        /// Destroys a glyph atlas. The page pixel buffers are owned by the caller.
+        /// </summary>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode DestroyGlyphAtlas(IntPtr ctx, IntPtr atlas);
+
+        /// <summary>
+        /// Sets the pixel buffer of an atlas page, e.g. the pixel data of a texture array slice.
+        /// The buffer must stay alive as long as the atlas uses it.
+        /// </summary>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode SetGlyphAtlasPage(
+            IntPtr ctx,
+            IntPtr atlas,
+            int page,
+            NativeBuffer<byte> pixels);
+
+        /// <summary>
+        /// Adds glyphs that are already placed and rendered, e.g. the glyphs of a baked font asset.
+        /// </summary>
+        /// <param name="font">Caller chosen id of the font the glyphs belong to, 0 for atlases with a single font.</param>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode RegisterAtlasGlyphs(
+            IntPtr ctx,
+            IntPtr atlas,
+            int font,
+            in NativeBuffer<GlyphMetrics> glyphs,
+            int frame);
+
+        /// <summary>
+        /// Marks glyphs of a font as used in the given frame. Glyphs used in the current frame are never evicted.
+        /// </summary>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode TouchAtlasGlyphs(
+            IntPtr ctx,
+            IntPtr atlas,
+            int font,
+            in NativeBuffer<int> glyphIndices,
+            int frame);
+
+        /// <summary>
+        /// Drops every glyph of a font from a shared atlas and clears its tiles, e.g. before unloading the font.
+        /// The space is reclaimed by the next InsertAtlasGlyphs that doesn't fit, its remap reports the tiles it moved.
+        /// </summary>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode RemoveAtlasFont(
+            IntPtr ctx,
+            IntPtr atlas,
+            int font,
+            out int count);
+
+        /// <summary>
+        /// Places glyphs in the atlas, evicting and compacting when they don't fit. The placed glyphs still have to be
+        /// rendered with <see cref="RenderGlyphsToAtlas"/>.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="atlas">Glyph atlas.</param>
+        /// <param name="font">Font the glyphs belong to.</param>
+        /// <param name="frame">Current frame.</param>
+        /// <param name="allocator">Allocator for the remap buffers.</param>
+        /// <param name="refGlyphs">Glyphs with their atlas size set, receive their placement. AtlasPage is -1 if a glyph didn't fit.</param>
+        /// <param name="outRemap">New metrics of previously rendered glyphs of any font that moved, AtlasPage is -1 for evicted glyphs. Empty if nothing changed.</param>
+        /// <param name="outRemapFonts">Font of every glyph in <paramref name="outRemap"/>.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode InsertAtlasGlyphs(
+            IntPtr ctx,
+            IntPtr atlas,
+            int font,
+            int frame,
+            Allocator allocator,
+            ref NativeBuffer<GlyphMetrics> refGlyphs,
+            out NativeBuffer<GlyphMetrics> outRemap,
+            out NativeBuffer<int> outRemapFonts);
+
+        /// <summary>
+        /// Queues glyphs for asynchronous rendering on the library's background workers.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="atlasConfig">Atlas configuration.</param>
+        /// <param name="renderConfig">Render configuration.</param>
+        /// <param name="priority">Higher priorities are rendered first, requests of equal priority in submission order.</param>
+        /// <param name="glyphs">Packed glyphs, copied into the queue.</param>
+        /// <param name="texture">Atlas page the glyphs are packed into. Must stay alive until the glyphs complete or the font is unloaded.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode EnqueueGlyphRenders(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            AtlasConfig atlasConfig,
+            RenderConfig renderConfig,
+            int priority,
+            in NativeBuffer<GlyphMetrics> glyphs,
+            NativeBuffer<byte> texture);
+
+        /// <summary>
+        /// Returns the glyphs of a font that finished rendering since the last poll.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="allocator">Allocator for the output buffer.</param>
+        /// <param name="maxCount">Maximum number of glyphs to return, 0 for all.</param>
+        /// <param name="glyphs">Completed glyphs, empty if none completed.</param>
+        /// <param name="pendingCount">Number of glyphs of the font still queued or rendering.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode PollCompletedGlyphs(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            Allocator allocator,
+            int maxCount,
+            out NativeBuffer<GlyphMetrics> glyphs,
+            out int pendingCount);
+
+        /// <summary>
+        /// Drops the queued and completed glyphs of a font and waits for the ones being rendered.
+        /// <see cref="UnloadFont"/> does this implicitly.
+        /// </summary>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode CancelGlyphRenders(IntPtr ctx, IntPtr fontHandle);
+
+        /// <summary>
+        /// Builds the vertices of a laid-out text block so it renders as one mesh, four vertices per glyph.
+        /// Only the glyphs in [first, first + count) are written, which allows partial updates of a changed range.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="config">Atlas configuration, units per em and font size.</param>
+        /// <param name="glyphTable">Glyph metrics sorted by glyph index.</param>
+        /// <param name="glyphs">Placed glyphs of the whole text block.</param>
+        /// <param name="first">First glyph to rebuild.</param>
+        /// <param name="count">Number of glyphs to rebuild.</param>
+        /// <param name="vertices">Vertex buffer of the whole text block.</param>
+        /// <returns><see cref="ReturnCode.InvalidArgument"/> if the range exceeds the glyphs or the vertex buffer.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode BuildTextMesh(
+            IntPtr ctx,
+            TextMeshConfig config,
+            in NativeBuffer<GlyphMetrics> glyphTable,
+            in NativeBuffer<GlyphPlacement> glyphs,
+            int first,
+            int count,
+            ref NativeBuffer<GlyphVertex> vertices);
+
+        /// <summary>
+        /// Triangulates glyph outlines so very large text can be drawn without atlas tiles. Curves stay exact at any
+        /// size through the Loop-Blinn coordinates of <see cref="OutlineVertex"/>. Meshes are built on first use and
+        /// cached on the font.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="fontHandle">Handle to the font.</param>
+        /// <param name="glyphs">Glyph indices.</param>
+        /// <param name="allocator">Allocator for the output buffers.</param>
+        /// <param name="vertices">Triangle list of all glyphs.</param>
+        /// <param name="ranges">One range of <paramref name="vertices"/> per glyph index.</param>
+        /// <returns>ErrorCode indicating success or failure.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode GetGlyphOutlineMeshes(
+            IntPtr ctx,
+            IntPtr fontHandle,
+            in NativeBuffer<int> glyphs,
+            Allocator allocator,
+            out NativeBuffer<OutlineVertex> vertices,
+            out NativeBuffer<OutlineMeshRange> ranges);
+
+        /// <summary>
+        /// Bounds the FreeType memory of all fonts of the context. Past the budget, the faces and cached outlines of
+        /// the least recently used fonts are closed and reopened from the font data on their next use.
+        /// </summary>
+        /// <param name="ctx">Library context.</param>
+        /// <param name="maxBytes">Budget in bytes, 0 for no limit which is the default.</param>
+        /// <param name="bytes">FreeType memory charged to the fonts after trimming to the budget.</param>
+        /// <returns><see cref="ReturnCode.InvalidArgument"/> if <paramref name="maxBytes"/> is negative.</returns>
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern ReturnCode SetFaceCacheBudget(
+            IntPtr ctx,
+            long maxBytes,
+            out long bytes);
 
         /// <summary>
         /// Retrieves debug information from the library.
@@ -1,5 +1,7 @@
 using System;
 using System.Runtime.InteropServices;
+using Elfenlabs.Collections;
+using Unity.Mathematics;
 
 namespace Elfenlabs.Text
 {
@@ -9,9 +11,14 @@ namespace Elfenlabs.Text
 
         // General errors
         Failure = 0001,
+        InvalidArgument = 0002,
+        AllocationError = 0003,
 
         // Font errors
-        FontNotFound = 1000
+        FontNotFound = 1000,
+
+        // Shaping errors
+        ShapingOutTooSmall = 2000
     }
 
     public enum GlyphRenderFlags : int
@@ -19,13 +26,93 @@ namespace Elfenlabs.Text
         None = 0,
         ResolveIntersection = 1 << 0,
         Test = 1 << 1,
+        // Hinted 8-bit coverage bitmaps rasterized by FreeType instead of MTSDF, cheaper and crisper for small UI sizes
+        RasterizeBitmap = 1 << 2,
+    }
+
+    public enum CharsetFlags : int
+    {
+        None = 0,
+        // Also collect ligatures and alternates reachable through the font's GSUB lookups
+        SubstituteClosure = 1 << 0,
+    }
+
+    /// <summary>
+    /// Block compressed formats for atlas pages.
+    /// </summary>
+    public enum AtlasCompression : int
+    {
+        Uncompressed = 0,
+        // One channel, 8 bytes per 4x4 block. SDF, PSDF and bitmap pages
+        BC4 = 1,
+        // First two channels, 16 bytes per 4x4 block
+        BC5 = 2,
+        // RGBA, 16 bytes per 4x4 block. MSDF and MTSDF pages
+        BC7 = 3,
+    }
+
+    /// <summary>
+    /// Error of a compressed atlas page against the uncompressed pixels.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct CompressionReport
+    {
+        public float RMSE;
+        // In dB, 0 when the encoding is lossless
+        public float PSNR;
+        // Largest absolute difference of a single channel value
+        public int MaxError;
+        public int BlockCount;
     }
 
+    public enum SubsetFlags : int
+    {
+        None = 0,
+        // Strip TrueType instructions and CFF hints, only bitmap rendering uses them
+        DropHinting = 1 << 0,
+        // Instance variable fonts at their default axis values and drop the variation tables
+        PinVariations = 1 << 1,
+        // Keep the original glyph ids so atlases baked from the full font stay valid
+        RetainGlyphIds = 1 << 2,
+    }
+
+    /// <summary>
+    /// Kind of distance field rendered into the atlas, decides the number of texture channels.
+    /// </summary>
+    public enum GlyphFieldType : int
+    {
+        // Multi-channel with true distance in alpha, 4 channels
+        MTSDF = 0,
+        // Multi-channel, keeps sharp corners, 3 channels
+        MSDF = 1,
+        // Single-channel perpendicular distance, 1 channel
+        PSDF = 2,
+        // Single-channel true distance with rounded corners, roughly a quarter of the MTSDF cost, 1 channel
+        SDF = 3,
+    }
+
+    /// <summary>
+    /// MSDF error correction mode, ignored by single-channel fields.
+    /// </summary>
+    public enum GlyphErrorCorrection : int
+    {
+        EdgePriority = 0,
+        Disabled = 1,
+        EdgeOnly = 2,
+        Indiscriminate = 3,
+    }
+
+    /// <summary>
+    /// How a dynamic glyph atlas closes the holes left by evicted glyphs, set through <see cref="AtlasConfig.Flags"/>.
+    /// </summary>
     public enum AtlasCompactFlags : int
     {
         None = 0,
+        // Slide tiles towards the left border, free space collects at the end of every row
         FillEnd = 1 << 0,
+        // Slide tiles towards the bottom border, free space collects at the top of the page
         Gravity = 1 << 1,
+        // Alternate Gravity and FillEnd passes until no tile moves
         ZigZag = 1 << 2,
     }
 
@@ -44,17 +131,23 @@ namespace Elfenlabs.Text
 
         // Size of the glyph in pixels (used for scaling)
         public int GlyphSize;
-        
+
+        // AtlasCompactFlags used when a dynamic glyph atlas evicts glyphs
         public int Flags;
 
+        // Adaptive sizing bounds in pixels per em, when both are set every glyph picks its own size from its outline complexity
+        public int MinGlyphSize;
+        public int MaxGlyphSize;
+
         public readonly bool Equals(AtlasConfig other)
         {
-            return Size == other.Size && Padding == other.Padding && Margin == other.Margin && GlyphSize == other.GlyphSize && Flags == other.Flags;
+            return Size == other.Size && Padding == other.Padding && Margin == other.Margin && GlyphSize == other.GlyphSize && Flags == other.Flags
+                && MinGlyphSize == other.MinGlyphSize && MaxGlyphSize == other.MaxGlyphSize;
         }
 
         public override readonly int GetHashCode()
         {
-            return HashCode.Combine(Size, Padding, Margin, GlyphSize, Flags);
+            return HashCode.Combine(Size, Padding, Margin, GlyphSize, Flags, MinGlyphSize, MaxGlyphSize);
         }
     };
 
@@ -67,6 +160,31 @@ namespace Elfenlabs.Text
 
         // Flags for rendering the glyphs
         public GlyphRenderFlags Flags;
+
+        // Distance field type
+        public GlyphFieldType FieldType;
+
+        // Error correction for the multi-channel field types
+        public GlyphErrorCorrection ErrorCorrection;
+
+        /// <summary>
+        /// Bytes per atlas pixel, matches AtlasBytesPerPixel in the native library.
+        /// </summary>
+        public readonly int BytesPerPixel
+        {
+            get
+            {
+                if ((Flags & GlyphRenderFlags.RasterizeBitmap) != 0)
+                    return 1;
+                return FieldType switch
+                {
+                    GlyphFieldType.MSDF => 3,
+                    GlyphFieldType.PSDF => 1,
+                    GlyphFieldType.SDF => 1,
+                    _ => 4,
+                };
+            }
+        }
     }
 
     [Serializable]
@@ -84,6 +202,21 @@ namespace Elfenlabs.Text
         public readonly int UnderlineThickness;
     }
 
+    /// <summary>
+    /// Unscaled box and advances of a glyph, in font units.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct GlyphTableMetrics
+    {
+        public int LeftFontUnits;
+        public int TopFontUnits;
+        public int WidthFontUnits;
+        public int HeightFontUnits;
+        public int AdvanceXFontUnits;
+        // Negative downwards like HarfBuzz positions
+        public int AdvanceYFontUnits;
+    }
+
     [Serializable]
     [StructLayout(LayoutKind.Sequential)]
     public struct ShapingGlyph
@@ -95,4 +228,129 @@ namespace Elfenlabs.Text
         public int XAdvance;
         public int YAdvance;
     }
-}
\ No newline at end of file
+
+    /// <summary>
+    /// Caret of a byte offset, from <see cref="FontLibrary.GetCaretPosition"/>.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct CaretPosition
+    {
+        // Pen x from the start of the line
+        public float XEm;
+        public int Line;
+        // Glyphs of the cluster holding the caret
+        public int FirstGlyph;
+        public int GlyphCount;
+    }
+
+    /// <summary>
+    /// Streams produced by <see cref="FontLibrary.ShapeTextStreams"/>, only the requested ones are allocated.
+    /// </summary>
+    public enum ShapeStreams : int
+    {
+        None = 0,
+        // uint glyph index per glyph
+        GlyphIds = 1 << 0,
+        // ushort glyph index per glyph, takes precedence over GlyphIds
+        GlyphIds16 = 1 << 1,
+        // uint cluster (byte offset into the UTF-8 text) per glyph
+        Clusters = 1 << 2,
+        // float2 advance in em per glyph
+        Advances = 1 << 3,
+        // float2 offset in em per glyph
+        Offsets = 1 << 4,
+    }
+
+    /// <summary>
+    /// Shaped glyphs as structure-of-arrays streams with positions already scaled to em.
+    /// Streams that were not requested are left empty.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ShapedGlyphStreams : IDisposable
+    {
+        public int Count;
+        public ShapeStreams Streams;
+        // uint or ushort per glyph, see ShapeStreams.GlyphIds16
+        public NativeBuffer<byte> GlyphIds;
+        public NativeBuffer<uint> Clusters;
+        public NativeBuffer<float2> Advances;
+        public NativeBuffer<float2> Offsets;
+
+        public void Dispose()
+        {
+            if ((Streams & (ShapeStreams.GlyphIds | ShapeStreams.GlyphIds16)) != 0)
+                GlyphIds.Dispose();
+            if ((Streams & ShapeStreams.Clusters) != 0)
+                Clusters.Dispose();
+            if ((Streams & ShapeStreams.Advances) != 0)
+                Advances.Dispose();
+            if ((Streams & ShapeStreams.Offsets) != 0)
+                Offsets.Dispose();
+        }
+    }
+
+    /// <summary>
+    /// A laid-out glyph of a text block, input of <see cref="FontLibrary.BuildTextMesh"/>.
+    /// </summary>
+    [Serializable]
+    [StructLayout(LayoutKind.Sequential)]
+    public struct GlyphPlacement
+    {
+        public int GlyphIndex;
+        // Pen position from layout, y grows downwards
+        public float2 PositionEm;
+        // Shaping offset, y grows upwards
+        public float2 OffsetEm;
+        // RGBA8, r in the lowest byte
+        public uint Color;
+    }
+
+    /// <summary>
+    /// Vertex of a text mesh, four per glyph ordered bottom-left, top-left, top-right, bottom-right.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct GlyphVertex
+    {
+        public float3 Position;
+        // Atlas uv in xy, atlas page in z
+        public float3 UV;
+        public uint Color;
+    }
+
+    [Serializable]
+    [StructLayout(LayoutKind.Sequential)]
+    public struct TextMeshConfig
+    {
+        // Atlas the glyph table was packed with
+        public AtlasConfig AtlasConfig;
+        public int UnitsPerEM;
+        // Font size in world units
+        public float EmToWorld;
+    }
+
+    /// <summary>
+    /// Vertex of a glyph outline mesh, EM-normalized with y up from the glyph origin. A fragment is inside the glyph
+    /// where <c>Side * (UV.x * UV.x - UV.y) &lt;= 0</c>, interior triangles always pass.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct OutlineVertex
+    {
+        public float2 Position;
+        // Loop-Blinn curve coordinates
+        public float2 UV;
+        // 1 where the curve bulges out of the glyph, -1 where it bulges into it
+        public float Side;
+    }
+
+    /// <summary>
+    /// Triangles of one glyph in a batch of outline meshes.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct OutlineMeshRange
+    {
+        public int GlyphIndex;
+        public int FirstVertex;
+        // 3 per triangle, 0 for glyphs without an outline
+        public int VertexCount;
+    }
+}
@@ -13,12 +13,10 @@ namespace Elfenlabs.Text
     [UpdateAfter(typeof(TextGlyphInitializationSystem))]
     public partial struct FontMissingGlyphHandlingSystem : ISystem
     {
-        NativeHashMap<FontAssetRuntimeData, JobHandle> existingUpdateJobs;
-
-        void OnCreate(ref SystemState state)
-        {
-            existingUpdateJobs = new NativeHashMap<FontAssetRuntimeData, JobHandle>(8, Allocator.Persistent);
-        }
+        /// <summary>
+        /// Render queue priority of glyphs requested by text entities, above background warm-up requests.
+        /// </summary>
+        public const int VisibleTextPriority = 100;
 
         void OnUpdate(ref SystemState state)
         {
@@ -37,15 +35,18 @@ namespace Elfenlabs.Text
                 if (fontAssetRuntime.PrototypeEntity == Entity.Null)
                     continue;
 
-                if (existingUpdateJobs.TryGetValue(fontAssetRuntime, out var existingJobHandle))
+                // Upload the texture as soon as any queued glyph is done, the rest follows in later frames
+                FontLibrary.PollCompletedGlyphs(
+                    pluginHandle,
+                    fontAssetRuntime.Description.Handle,
+                    Allocator.Temp,
+                    0,
+                    out var completedGlyphs,
+                    out _);
+                if (completedGlyphs.Count() > 0)
                 {
-                    if (existingJobHandle.IsCompleted)
-                    {
-                        // Upload the texture to the GPU
-                        (egs.GetMaterial(fontAssetRuntime.MaterialID).mainTexture as Texture2DArray).Apply();
-
-                        existingUpdateJobs.Remove(fontAssetRuntime);
-                    }
+                    (egs.GetMaterial(fontAssetRuntime.MaterialID).mainTexture as Texture2DArray).Apply();
+                    completedGlyphs.Dispose();
                 }
 
                 var missingGlyphSet = fontAssetRuntime.MissingGlyphSet;
@@ -55,20 +56,27 @@ namespace Elfenlabs.Text
                 // Create parameters
                 var param = new AtlasUpdateParameters(fontAssetRuntime)
                 {
-                    Glyphs = new NativeBuffer<GlyphMetrics>(fontAssetRuntime.MissingGlyphSet.Count(), Allocator.Persistent) // Persistent might be overkill, but it's safe
+                    Glyphs = new NativeBuffer<GlyphMetrics>(fontAssetRuntime.MissingGlyphSet.Count(), Allocator.TempJob)
                 };
 
                 // Run glyph metrics update job
                 var updateMetricsJob = new UpdateGlyphMetricsJob
                 {
                     PluginHandle = pluginHandle,
-                    Parameters = param
+                    Frame = Time.frameCount,
+                    Parameters = param,
+                    Compacted = new NativeReference<bool>(Allocator.TempJob)
                 };
 
                 var updateMetricsHandle = updateMetricsJob.Schedule();
 
                 updateMetricsHandle.Complete();
 
+                // Eviction and compaction rewrote pixels of already rendered tiles
+                if (updateMetricsJob.Compacted.Value)
+                    (egs.GetMaterial(fontAssetRuntime.MaterialID).mainTexture as Texture2DArray).Apply();
+                updateMetricsJob.Compacted.Dispose();
+
                 // Immediately reupdate the glyphs with the new metrics
                 // We do this before the atlas rendering itself so that get get instant layout updates
                 // TODO: at the moment all text that shares the same font asset will be updated.
@@ -83,30 +91,34 @@ namespace Elfenlabs.Text
 
                 missingGlyphSet.Clear();
 
-                // Obtain pointer to the texture buffer
+                // Hand the glyphs to the native render queue page by page, they are polled in the following frames
                 var material = egs.GetMaterial(fontAssetRuntime.MaterialID);
                 var textureArray = material.mainTexture as Texture2DArray;
-                var textureBuffer = NativeBuffer<Color32>.Alias(textureArray.GetPixelData<Color32>(0, 0));
-                param.TextureBuffer = textureBuffer;
-
-                // Schedule render job
-                var renderJob = new RenderAtlasJob
+                var pageGlyphs = new NativeList<GlyphMetrics>(param.Glyphs.Count(), Allocator.Temp);
+                for (int page = 0; page < textureArray.depth; page++)
                 {
-                    PluginHandle = pluginHandle,
-                    Parameters = param
-                };
-
-                var renderHandle = renderJob.Schedule(updateMetricsHandle);
-
-                // If there is an ongoing render job running, combine the dependencies
-                if (existingJobHandle != default)
-                {
-                    renderHandle = JobHandle.CombineDependencies(renderHandle, existingJobHandle);
+                    pageGlyphs.Clear();
+                    for (int i = 0; i < param.Glyphs.Count(); i++)
+                    {
+                        if (param.Glyphs[i].AtlasPage == page)
+                            pageGlyphs.Add(param.Glyphs[i]);
+                    }
+                    if (pageGlyphs.Length == 0)
+                        continue;
+
+                    FontLibrary.EnqueueGlyphRenders(
+                        pluginHandle,
+                        fontAssetRuntime.Description.Handle,
+                        fontAssetRuntime.AssetReference.Value.AtlasConfig,
+                        fontAssetRuntime.AssetReference.Value.RenderConfig,
+                        VisibleTextPriority,
+                        NativeBuffer<GlyphMetrics>.Alias(pageGlyphs.AsArray()),
+                        NativeBuffer<byte>.Alias(textureArray.GetPixelData<byte>(0, page)));
                 }
-                existingUpdateJobs[fontAssetRuntime] = renderHandle;
+                pageGlyphs.Dispose();
 
-                // Dispose of the glyph metrics buffer after the render job is done
-                param.Glyphs.Dispose(renderHandle);
+                // The queue keeps its own copy of the glyphs
+                param.Glyphs.Dispose();
             }
         }
 
@@ -117,12 +129,10 @@ namespace Elfenlabs.Text
         {
             public readonly FontAssetRuntimeData FontRuntime;
             public NativeBuffer<GlyphMetrics> Glyphs;
-            public NativeBuffer<Color32> TextureBuffer;
             public AtlasUpdateParameters(FontAssetRuntimeData fontRuntime)
             {
                 FontRuntime = fontRuntime;
                 Glyphs = default;
-                TextureBuffer = default;
             }
         }
 
@@ -134,9 +144,14 @@ namespace Elfenlabs.Text
             [NativeDisableUnsafePtrRestriction]
             public IntPtr PluginHandle;
 
+            public int Frame;
+
             [NativeDisableUnsafePtrRestriction]
             public AtlasUpdateParameters Parameters;
 
+            // Whether placing the glyphs moved or evicted rendered tiles
+            public NativeReference<bool> Compacted;
+
             public void Execute()
             {
                 // Create glyph buffer from the missing glyph set
@@ -148,51 +163,55 @@ namespace Elfenlabs.Text
                 }
 
                 // Obtain glyph metrics for glyph sizes
-                FontLibrary.GetGlyphMetrics(
+                FontLibrary.GetGlyphAtlasMetrics(
                     PluginHandle,
                     Parameters.FontRuntime.Description.Handle,
-                    Parameters.FontRuntime.AssetReference.Value.AtlasConfig.GlyphSize,
-                    Parameters.FontRuntime.AssetReference.Value.AtlasConfig.Padding,
+                    Parameters.FontRuntime.AssetReference.Value.AtlasConfig,
+                    Parameters.FontRuntime.AssetReference.Value.RenderConfig,
                     ref Parameters.Glyphs);
 
-                // Obtain glyph positions in the atlas
-                var packedCount = Parameters.FontRuntime.Atlas.PackGlyphs(Parameters.Glyphs.AsNativeArray());
+                // Obtain glyph positions in the atlas, cold glyphs are evicted and the pages compacted when full
+                FontLibrary.InsertAtlasGlyphs(
+                    PluginHandle,
+                    Parameters.FontRuntime.DynamicAtlas,
+                    0,
+                    Frame,
+                    Allocator.Temp,
+                    ref Parameters.Glyphs,
+                    out var remap,
+                    out var remapFonts);
+
+                var glyphMap = Parameters.FontRuntime.GlyphMap;
+                var atlasSize = Parameters.FontRuntime.AssetReference.Value.AtlasConfig.Size;
+
+                // Moved glyphs get their new rect, evicted ones become missing again and are re-requested by the text using them
+                Compacted.Value = remap.Count() > 0;
+                for (int i = 0; i < remap.Count(); i++)
+                {
+                    var glyph = remap[i];
+                    glyphMap.Remove(glyph.CodePoint);
+                    if (glyph.AtlasPage >= 0)
+                        glyphMap.Add(glyph.CodePoint, new GlyphRuntimeData(glyph, atlasSize));
+                }
+                if (remap.Count() > 0)
+                {
+                    remap.Dispose();
+                    remapFonts.Dispose();
+                }
 
-                // Update glyph data into the glyph map
+                // Update glyph data into the glyph map, glyphs that didn't fit stay missing
                 for (int i = 0; i < Parameters.Glyphs.Count(); i++)
                 {
                     var glyph = Parameters.Glyphs[i];
-                    Parameters.FontRuntime.GlyphMap.Add(
-                        glyph.CodePoint,
-                        new GlyphRuntimeData(
-                            glyph,
-                            Parameters.FontRuntime.AssetReference.Value.AtlasConfig.Size));
+                    if (glyph.AtlasPage < 0)
+                    {
+                        Debug.LogWarning($"Glyph {glyph.CodePoint} doesn't fit the atlas");
+                        continue;
+                    }
+                    glyphMap.Remove(glyph.CodePoint);
+                    glyphMap.Add(glyph.CodePoint, new GlyphRuntimeData(glyph, atlasSize));
                 }
             }
         }
-
-        /// <summary>
-        /// The second job, responsible for rendering the glyphs into the atlas texture on the CPU
-        /// After this job, the main thread needs to update the texture in the GPU by using texture.Apply()
-        /// </summary>
-        partial struct RenderAtlasJob : IJob
-        {
-            [NativeDisableUnsafePtrRestriction]
-            public IntPtr PluginHandle;
-
-            [NativeDisableUnsafePtrRestriction]
-            public AtlasUpdateParameters Parameters;
-
-            public void Execute()
-            {
-                FontLibrary.RenderGlyphsToAtlas(
-                    PluginHandle,
-                    Parameters.FontRuntime.Description.Handle,
-                    Parameters.FontRuntime.AssetReference.Value.AtlasConfig,
-                    Parameters.FontRuntime.AssetReference.Value.RenderConfig,
-                    in Parameters.Glyphs,
-                    ref Parameters.TextureBuffer);
-            }
-        }
     }
 }
\ No newline at end of file
@@ -18,6 +18,9 @@ namespace Elfenlabs.Text
         public int HeightFontUnits;
         public int LeftFontUnits;
         public int TopFontUnits;
+        public int AtlasPage;
+        // Pixels per em of the tile, differs from AtlasConfig.GlyphSize with adaptive sizing
+        public int GlyphSizePx;
 
         public int X { readonly get => AtlasXPx; set => AtlasXPx = value; }
         public int Y { readonly get => AtlasYPx; set => AtlasYPx = value; }
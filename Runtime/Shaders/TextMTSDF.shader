@@ -37,13 +37,21 @@ Shader "Elfenlabs/Text-MTSDF"
             #pragma vertex vert
             #pragma fragment frag
             #pragma multi_compile _ DOTS_INSTANCING_ON
+            #pragma shader_feature_local _ _GLYPH_BITMAP _GLYPH_SDF
+            #pragma shader_feature_local _ _GLYPH_MESH
 
             #include "Packages/com.unity.render-pipelines.universal/ShaderLibrary/Core.hlsl"
 
             struct VertexInput
             {
                 float4 position : POSITION;
+                #if defined(_GLYPH_MESH)
+                // Text meshes built by BuildTextMesh carry atlas uv, page and color per vertex
+                float3 uv : TEXCOORD0;
+                float4 color : COLOR;
+                #else
                 float2 uv : TEXCOORD0;
+                #endif
                 UNITY_VERTEX_INPUT_INSTANCE_ID
             };
 
@@ -115,9 +123,15 @@ Shader "Elfenlabs/Text-MTSDF"
 
                 OUT.position = TransformObjectToHClip(IN.position.xyz);
 
+                #if defined(_GLYPH_MESH)
+                OUT.atlasUV = IN.uv.xy;
+                OUT.texIndex = IN.uv.z;
+                OUT.baseColor = IN.color * _GlyphBaseColor;
+                #else
                 OUT.atlasUV = getAtlasUV(IN.uv, _GlyphRect);
                 OUT.texIndex = _GlyphAtlasIndex;
                 OUT.baseColor = _GlyphBaseColor;
+                #endif
                 OUT.outlineThickness = _GlyphOutlineThickness;
                 OUT.outlineColor = _GlyphOutlineColor;
                 OUT.threshold = _GlyphThreshold;
@@ -127,9 +141,19 @@ Shader "Elfenlabs/Text-MTSDF"
 
             float4 frag(FragmentInput IN) : SV_Target
             {
+                #if defined(_GLYPH_BITMAP)
+                // Bitmap atlases store hinted coverage in the red channel, no distance to threshold
+                float coverage = SAMPLE_TEXTURE2D_ARRAY(_MainTex, sampler_MainTex, IN.atlasUV, IN.texIndex).r;
+                return float4(IN.baseColor.rgb, coverage * IN.baseColor.a);
+                #else
                 // Sample MSDF texture
                 float4 msd = SAMPLE_TEXTURE2D_ARRAY(_MainTex, sampler_MainTex, IN.atlasUV, IN.texIndex);
+                #if defined(_GLYPH_SDF)
+                // Single-channel SDF/PSDF atlases store the distance in the red channel
+                float sd = msd.r;
+                #else
                 float sd = median(msd.r, msd.g, msd.b);
+                #endif
 
                 float screenPixelDist = fwidth(sd);
 
@@ -171,6 +195,7 @@ Shader "Elfenlabs/Text-MTSDF"
 
                 // Return non-premultiplied color suitable for Blend SrcAlpha OneMinusSrcAlpha
                 return float4(blendedColor, combinedAlpha);
+                #endif
             }
             ENDHLSL
         }
@@ -1,3 +1,4 @@
+using System;
 using Elfenlabs.Collections;
 using Unity.Collections;
 using Unity.Entities;
@@ -29,6 +30,7 @@ namespace Elfenlabs.Text
             {
                 ECB = ecb.AsParallelWriter(),
                 FontPluginHandle = SystemAPI.GetSingleton<FontPluginRuntimeHandle>(),
+                Frame = Time.frameCount,
                 GlyphRequireUpdateLookup = SystemAPI.GetComponentLookup<TextGlyphRequireUpdate>(),
                 LayoutRequireUpdateLookup = SystemAPI.GetComponentLookup<TextLayoutRequireUpdate>()
             };
@@ -41,6 +43,7 @@ namespace Elfenlabs.Text
         {
             public EntityCommandBuffer.ParallelWriter ECB;
             public FontPluginRuntimeHandle FontPluginHandle;
+            public int Frame;
             [NativeDisableParallelForRestriction]
             public ComponentLookup<TextGlyphRequireUpdate> GlyphRequireUpdateLookup;
             [NativeDisableParallelForRestriction]
@@ -65,36 +68,46 @@ namespace Elfenlabs.Text
 
                 textGlyphs.Clear();
 
-                // Generate glyphs for each character in the string
-                FontLibrary.ShapeText(
-                    FontPluginHandle.Value,
-                    fontRuntimeData.Description.Handle,
-                    Allocator.Temp,
-                    textStringBuffer.AsNativeBuffer().ReinterpretCast<TextStringBuffer, byte>(),
-                    out var glyphShape);
+                // Generate glyphs for each character in the string, positions come back in em.
+                // Shape into job-local buffers sized for one glyph per byte, which covers nearly all text;
+                // when it doesn't, the native side reports the exact count and the cached result is copied again.
+                var text = textStringBuffer.AsNativeBuffer().ReinterpretCast<TextStringBuffer, byte>();
+                var shaped = AllocateStreams(text.Count());
+                if (FontLibrary.ShapeTextStreamsInto(FontPluginHandle.Value, fontRuntimeData.Description.Handle, in text, ref shaped) == ReturnCode.ShapingOutTooSmall)
+                {
+                    var count = shaped.Count;
+                    shaped.Dispose();
+                    shaped = AllocateStreams(count);
+                    FontLibrary.ShapeTextStreamsInto(FontPluginHandle.Value, fontRuntimeData.Description.Handle, in text, ref shaped);
+                }
+                var glyphIds = shaped.GlyphIds.ReinterpretCast<byte, int>();
 
-                var atlasPixelToEm = 1f / fontAssetData.Value.Value.AtlasConfig.GlyphSize;
+                var atlasGlyphSize = fontAssetData.Value.Value.AtlasConfig.GlyphSize;
                 var fontUnitsToEm = 1f / fontRuntimeData.Description.UnitsPerEM;
-                for (int i = 0; i < glyphShape.Count(); i++)
+                var usedGlyphs = new NativeList<int>(shaped.Count, Allocator.Temp);
+                for (int i = 0; i < shaped.Count; i++)
                 {
-                    Debug.Log("Trying to add glyph: " + glyphShape[i].CodePoint);
-                    if (fontRuntimeData.GlyphMap.TryGetValue(glyphShape[i].CodePoint, out var glyphInfo))
+                    var glyphId = glyphIds[i];
+                    Debug.Log("Trying to add glyph: " + glyphId);
+                    if (fontRuntimeData.GlyphMap.TryGetValue(glyphId, out var glyphInfo))
                     {
-                        Debug.Log("Glyph found: " + glyphShape[i].CodePoint);
+                        Debug.Log("Glyph found: " + glyphId);
+                        usedGlyphs.Add(glyphId);
                         
                         // Calculate runtime values in em units
-                        var advance = new float2(glyphShape[i].XAdvance, glyphShape[i].YAdvance) * fontUnitsToEm;
+                        var advance = shaped.Advances[i];
                         var bearingOffset = new float2(
                             glyphInfo.Metrics.LeftFontUnits * fontUnitsToEm,
                             (glyphInfo.Metrics.TopFontUnits - glyphInfo.Metrics.HeightFontUnits) * fontUnitsToEm
                         );
-                        var shapeOffset = new float2(glyphShape[i].XOffset, glyphShape[i].YOffset) * fontUnitsToEm;
+                        var shapeOffset = shaped.Offsets[i];
 
                         // Real size is the real size of the glyph itself without padding
                         var realSize = new float2(glyphInfo.Metrics.WidthFontUnits, glyphInfo.Metrics.HeightFontUnits) * fontUnitsToEm;
+                        var atlasPixelToEm = 1f / (glyphInfo.Metrics.GlyphSizePx > 0 ? glyphInfo.Metrics.GlyphSizePx : atlasGlyphSize);
                         var quadSize = realSize + (2f * fontAssetData.Value.Value.AtlasConfig.Padding * atlasPixelToEm);
 
-                        Debug.Log("Glyph: " + glyphShape[i].CodePoint + " - " + glyphInfo.Metrics.LeftFontUnits + " - " + glyphInfo.Metrics.TopFontUnits + " - " + glyphInfo.Metrics.WidthFontUnits + " - " + glyphInfo.Metrics.HeightFontUnits);
+                        Debug.Log("Glyph: " + glyphId + " - " + glyphInfo.Metrics.LeftFontUnits + " - " + glyphInfo.Metrics.TopFontUnits + " - " + glyphInfo.Metrics.WidthFontUnits + " - " + glyphInfo.Metrics.HeightFontUnits);
 
                         var glyphEntity = ECB.Instantiate(chunkIndexInQuery, fontRuntimeData.PrototypeEntity);
 
@@ -103,7 +116,7 @@ namespace Elfenlabs.Text
                         ECB.AddComponent(chunkIndexInQuery, glyphEntity, new LocalTransform { Scale = 1f });
                         ECB.AddComponent(chunkIndexInQuery, glyphEntity, new PostTransformMatrix { Value = float4x4.identity });
 
-                        ECB.AddComponent(chunkIndexInQuery, glyphEntity, new MaterialPropertyGlyphAtlasIndex { Value = 0 });
+                        ECB.AddComponent(chunkIndexInQuery, glyphEntity, new MaterialPropertyGlyphAtlasIndex { Value = glyphInfo.Metrics.AtlasPage });
                         ECB.AddComponent(chunkIndexInQuery, glyphEntity, new MaterialPropertyGlyphRect { Value = glyphInfo.AtlasUV });
 
                         // TODO: set conditional
@@ -114,7 +127,7 @@ namespace Elfenlabs.Text
                         ECB.AppendToBuffer(chunkIndexInQuery, entity, new TextGlyphBuffer
                         {
                             Entity = glyphEntity,
-                            Cluster = glyphShape[i].Cluster,
+                            Cluster = (int)shaped.Clusters[i],
                             PositionEm = float2.zero,
                             Line = 0,
                             AdvanceEm = advance,
@@ -125,10 +138,29 @@ namespace Elfenlabs.Text
                     }
                     else
                     {
-                        Debug.LogWarning($"Missing glyph: {glyphShape[i].CodePoint}");
-                        fontRuntimeData.MissingGlyphSet.Add(glyphShape[i].CodePoint);
+                        Debug.LogWarning($"Missing glyph: {glyphId}");
+                        fontRuntimeData.MissingGlyphSet.Add(glyphId);
                     }
                 }
+
+                // Glyphs of live text are never evicted in the frame they're used
+                if (fontRuntimeData.DynamicAtlas != IntPtr.Zero && usedGlyphs.Length > 0)
+                    FontLibrary.TouchAtlasGlyphs(FontPluginHandle.Value, fontRuntimeData.DynamicAtlas, 0, NativeBuffer<int>.Alias(usedGlyphs.AsArray()), Frame);
+                usedGlyphs.Dispose();
+
+                shaped.Dispose();
+            }
+
+            static ShapedGlyphStreams AllocateStreams(int capacity)
+            {
+                return new ShapedGlyphStreams
+                {
+                    Streams = ShapeStreams.GlyphIds | ShapeStreams.Clusters | ShapeStreams.Advances | ShapeStreams.Offsets,
+                    GlyphIds = new NativeBuffer<byte>(capacity * sizeof(int), Allocator.Temp),
+                    Clusters = new NativeBuffer<uint>(capacity, Allocator.Temp),
+                    Advances = new NativeBuffer<float2>(capacity, Allocator.Temp),
+                    Offsets = new NativeBuffer<float2>(capacity, Allocator.Temp),
+                };
             }
         }
     }
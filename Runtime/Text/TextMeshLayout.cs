@@ -0,0 +1,37 @@
+using Unity.Collections;
+using UnityEngine.Rendering;
+
+namespace Elfenlabs.Text
+{
+    /// <summary>
+    /// Mesh layout of the vertices written by <see cref="FontLibrary.BuildTextMesh"/>.
+    /// Materials need the _GLYPH_MESH keyword so the shader reads uv, page and color from the vertices.
+    /// </summary>
+    public static class TextMeshLayout
+    {
+        public static readonly VertexAttributeDescriptor[] VertexAttributes =
+        {
+            new(VertexAttribute.Position, VertexAttributeFormat.Float32, 3),
+            new(VertexAttribute.TexCoord0, VertexAttributeFormat.Float32, 3),
+            new(VertexAttribute.Color, VertexAttributeFormat.UNorm8, 4),
+        };
+
+        /// <summary>
+        /// Writes the two triangles of every glyph quad, the indices only depend on the glyph count.
+        /// </summary>
+        public static void FillIndices(NativeArray<int> indices, int glyphCount)
+        {
+            for (int i = 0; i < glyphCount; i++)
+            {
+                var vertex = i * 4;
+                var index = i * 6;
+                indices[index + 0] = vertex + 0;
+                indices[index + 1] = vertex + 1;
+                indices[index + 2] = vertex + 2;
+                indices[index + 3] = vertex + 2;
+                indices[index + 4] = vertex + 3;
+                indices[index + 5] = vertex + 0;
+            }
+        }
+    }
+}